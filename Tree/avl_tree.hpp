@@ -0,0 +1,222 @@
+#pragma once
+
+#include "binary_tree.hpp"
+
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+
+namespace avl_impl
+{
+
+	// Compares pairs by their first member, also accepts bare keys
+	template<typename Compare>
+	struct compare_first
+	{
+		using is_transparent = void;
+
+		template<typename K, typename V, typename U>
+		bool operator()(const std::pair<K, V>& lhs, const U& rhs) const { return comp(lhs.first, rhs); }
+
+		template<typename U, typename K, typename V>
+		bool operator()(const U& lhs, const std::pair<K, V>& rhs) const { return comp(lhs, rhs.first); }
+
+		template<typename K, typename V>
+		bool operator()(const std::pair<K, V>& lhs, const std::pair<K, V>& rhs) const { return comp(lhs.first, rhs.first); }
+
+		Compare comp;
+	};
+
+}
+
+
+/*
+	Ordered set balanced as AVL tree.
+	Elements are stored in binary_tree nodes, so the whole binary_tree API
+	and traverse_* functions work on tree() and root().
+	Heights are kept in the node height slot of binary_tree_augmentation::heights.
+*/
+template<typename T, typename Compare = std::less<>, typename Index = std::size_t>
+class avl_tree
+{
+public:
+	using tree_type = binary_tree<T, Index, binary_tree_augmentation::heights>;
+	using node = typename tree_type::node;
+
+	explicit avl_tree(Compare comp = Compare()) : tree_{ empty_binary_tree }, comp_{ comp } {}
+
+	const tree_type& tree() const { return tree_; }
+	node root() const { return tree_.root(); }
+
+	std::size_t size() const { return tree_.size(); }
+	bool empty() const { return root().is_null(); }
+
+	const T& value(const node& n) const { return tree_.value(n); }
+
+	// Modifications must not change position of the value in the order
+	T& value(const node& n) { return tree_.value(n); }
+
+	// Returns inserted node or node with equivalent value and insertion flag
+	template<typename... Args>
+	std::pair<node, bool> emplace(Args&&... args)
+	{
+		T value(std::forward<Args>(args)...);
+
+		node parent = node::null_node();
+		bool less = false;
+		for (node current = root(); !current.is_null();)
+		{
+			parent = current;
+			less = comp_(value, tree_.value(current));
+			if (!less && !comp_(tree_.value(current), value))
+				return { current, false };
+
+			current = less ? tree_.left(current) : tree_.right(current);
+		}
+
+		node result = node::null_node();
+		if (parent.is_null()) result = tree_.emplace_root(std::move(value));
+		else if (less) result = tree_.emplace_left(parent, std::move(value));
+		else result = tree_.emplace_right(parent, std::move(value));
+
+		retrace(parent);
+		return { result, true };
+	}
+
+	std::pair<node, bool> insert(const T& value) { return emplace(value); }
+	std::pair<node, bool> insert(T&& value) { return emplace(std::move(value)); }
+
+	template<typename Key>
+	node lower_bound(const Key& key) const { return binary_search_lower_bound(tree_, root(), key, comp_); }
+
+	template<typename Key>
+	node find(const Key& key) const { return binary_search_find(tree_, root(), key, comp_); }
+
+	template<typename Key>
+	bool contains(const Key& key) const { return !find(key).is_null(); }
+
+	template<typename Key>
+	bool erase(const Key& key)
+	{
+		const node n = find(key);
+		if (n.is_null()) return false;
+
+		erase(n);
+		return true;
+	}
+
+	// Value of the inorder successor may be moved into n, other nodes stay valid
+	void erase(node n)
+	{
+		if (!tree_.left(n).is_null() && !tree_.right(n).is_null())
+		{
+			node successor = tree_.right(n);
+			while (!tree_.left(successor).is_null())
+				successor = tree_.left(successor);
+
+			tree_.value(n) = std::move(tree_.value(successor));
+			n = successor;
+		}
+
+		const node child = tree_.left(n).is_null() ? tree_.right(n) : tree_.left(n);
+		const node parent = tree_.parent(n);
+		replace_child(parent, n, child);
+		tree_.remove_node(n);
+		retrace(parent);
+	}
+
+	void clear()
+	{
+		tree_ = tree_type(empty_binary_tree);
+	}
+
+private:
+	int height(const node& n) const { return tree_.subtree_height(n); }
+	void update_height(const node& n) { tree_.set_subtree_height(n, 1 + std::max(height(tree_.left(n)), height(tree_.right(n)))); }
+
+	void replace_child(const node& parent, const node& oldChild, const node& newChild)
+	{
+		if (parent.is_null())
+		{
+			tree_.set_root(newChild);
+		}
+		else if (tree_.left(parent) == oldChild)
+		{
+			tree_.set_left(parent, newChild);
+		}
+		else
+		{
+			tree_.set_right(parent, newChild);
+		}
+	}
+
+	node rotate_left(const node& x)
+	{
+		const node y = tree_.right(x);
+		const node parent = tree_.parent(x);
+		tree_.set_right(x, tree_.left(y));
+		replace_child(parent, x, y);
+		tree_.set_left(y, x);
+		update_height(x);
+		update_height(y);
+		return y;
+	}
+
+	node rotate_right(const node& x)
+	{
+		const node y = tree_.left(x);
+		const node parent = tree_.parent(x);
+		tree_.set_left(x, tree_.right(y));
+		replace_child(parent, x, y);
+		tree_.set_right(y, x);
+		update_height(x);
+		update_height(y);
+		return y;
+	}
+
+	node rebalance(const node& n)
+	{
+		const int balance = height(tree_.left(n)) - height(tree_.right(n));
+		if (balance > 1)
+		{
+			const node left = tree_.left(n);
+			if (height(tree_.left(left)) < height(tree_.right(left))) rotate_left(left);
+			return rotate_right(n);
+		}
+
+		if (balance < -1)
+		{
+			const node right = tree_.right(n);
+			if (height(tree_.right(right)) < height(tree_.left(right))) rotate_right(right);
+			return rotate_left(n);
+		}
+
+		return n;
+	}
+
+	// Restores heights and balance walking up from n, stops once subtree height is unchanged
+	void retrace(node n)
+	{
+		while (!n.is_null())
+		{
+			const int oldHeight = height(n);
+			update_height(n);
+			n = rebalance(n);
+			if (height(n) == oldHeight) break;
+
+			n = tree_.parent(n);
+		}
+	}
+
+private:
+	tree_type tree_;
+	Compare comp_;
+};
+
+
+template<typename T, typename Compare = std::less<>, typename Index = std::size_t>
+using avl_set = avl_tree<T, Compare, Index>;
+
+template<typename Key, typename Value, typename Compare = std::less<>, typename Index = std::size_t>
+using avl_map = avl_tree<std::pair<Key, Value>, avl_impl::compare_first<Compare>, Index>;
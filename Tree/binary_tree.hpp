@@ -2,38 +2,90 @@
 
 #include "registry.hpp"
 
-#include <queue>
 #include <vector>
 #include <limits>
+#include <cstdint>
 #include <cassert>
 #include <utility>
+#include <iterator>
 #include <algorithm>
+#include <functional>
+#include <type_traits>
+
+
+/*
+	Optional data stored in every binary_tree node, chosen at compile time
+	so that trees which don't need it don't pay for it in memory.
+*/
+enum class binary_tree_augmentation
+{
+	none,
+	parent_links,		// index of the parent, needed by stackless traversals and traversal ranges
+	order_statistics,	// parent links and count of nodes in the subtree, needed by subtree_size, select and rank
+	heights				// parent links and small height slot kept by balanced trees such as avl_tree
+};
 
 
 namespace binary_tree_impl
 {
 
+	template<typename Index, binary_tree_augmentation Augmentation = binary_tree_augmentation::none>
 	class inner_node
 	{
 	public:
-		static constexpr auto null_node_index = std::numeric_limits<std::size_t>::max();
+		static constexpr auto null_node_index = std::numeric_limits<Index>::max();
 
-		std::size_t left_index() const { return left_; }
-		void set_left_index(std::size_t index) { left_ = index; }
+		Index left_index() const { return left_; }
+		void set_left_index(Index index) { left_ = index; }
 		void reset_left_index() { set_left_index(null_node_index); }
 
-		std::size_t right_index() const { return right_; }
-		void set_right_index(std::size_t index) { right_ = index; }
+		Index right_index() const { return right_; }
+		void set_right_index(Index index) { right_ = index; }
 		void reset_right_index() { set_right_index(null_node_index); }
 
 	private:
-		std::size_t left_ = null_node_index;
-		std::size_t right_ = null_node_index;
+		Index left_ = null_node_index;
+		Index right_ = null_node_index;
+	};
+
+	template<typename Index>
+	class inner_node<Index, binary_tree_augmentation::parent_links> : public inner_node<Index>
+	{
+	public:
+		Index parent_index() const { return parent_; }
+		void set_parent_index(Index index) { parent_ = index; }
+		void reset_parent_index() { set_parent_index(inner_node::null_node_index); }
+
+	private:
+		Index parent_ = inner_node::null_node_index;
+	};
+
+	template<typename Index>
+	class inner_node<Index, binary_tree_augmentation::order_statistics> : public inner_node<Index, binary_tree_augmentation::parent_links>
+	{
+	public:
+		Index subtree_size() const { return subtreeSize_; }
+		void set_subtree_size(Index size) { subtreeSize_ = size; }
+
+	private:
+		Index subtreeSize_ = 1;
+	};
+
+	// Fits into the padding after the links for most value types
+	template<typename Index>
+	class inner_node<Index, binary_tree_augmentation::heights> : public inner_node<Index, binary_tree_augmentation::parent_links>
+	{
+	public:
+		int height() const { return height_; }
+		void set_height(int height) { height_ = static_cast<std::int8_t>(height); }
+
+	private:
+		std::int8_t height_ = 1;
 	};
 
 
-	template<typename T>
-	class inner_data_node : public inner_node
+	template<typename T, typename Index, binary_tree_augmentation Augmentation>
+	class inner_data_node : public inner_node<Index, Augmentation>
 	{
 	public:
 		template<typename... Args>
@@ -51,20 +103,33 @@ namespace binary_tree_impl
 }
 
 
-template<typename T>
+// Tag for constructing binary_tree without root node
+struct empty_binary_tree_t { explicit empty_binary_tree_t() = default; };
+inline constexpr empty_binary_tree_t empty_binary_tree{};
+
+// Order of nodes in memory after binary_tree::relayout
+enum class binary_tree_layout { eytzinger, van_emde_boas };
+
+
+template<typename T, typename Index = std::size_t, binary_tree_augmentation Augmentation = binary_tree_augmentation::none>
 class binary_tree
 {
+	using inner_type = binary_tree_impl::inner_data_node<T, Index, Augmentation>;
+
 public:
+	static constexpr bool has_parent_links = Augmentation != binary_tree_augmentation::none;
+	static constexpr bool has_order_statistics = Augmentation == binary_tree_augmentation::order_statistics;
+	static constexpr bool has_heights = Augmentation == binary_tree_augmentation::heights;
 
 	class node
 	{
 		friend class binary_tree;
-		explicit node(std::size_t index) : nodeIndex_{ index } {}
+		explicit node(Index index) : nodeIndex_{ index } {}
 	public:
-		std::size_t index() const { return nodeIndex_; }
-		bool is_null() const { return nodeIndex_ == binary_tree_impl::inner_node::null_node_index; }
+		Index index() const { return nodeIndex_; }
+		bool is_null() const { return nodeIndex_ == binary_tree_impl::inner_node<Index>::null_node_index; }
 
-		static node null_node() { return node(binary_tree_impl::inner_node::null_node_index); }
+		static node null_node() { return node(binary_tree_impl::inner_node<Index>::null_node_index); }
 
 		friend bool operator<(const node& lhs, const node& rhs) { return lhs.nodeIndex_ < rhs.nodeIndex_; }
 		friend bool operator>(const node& lhs, const node& rhs) { return lhs.nodeIndex_ > rhs.nodeIndex_; }
@@ -76,10 +141,12 @@ public:
 		friend bool operator!=(const node& lhs, const node& rhs) { return lhs.nodeIndex_ != rhs.nodeIndex_; }
 
 	private:
-		std::size_t nodeIndex_;
+		Index nodeIndex_;
 	};
 
 public:
+	using value_type = T;
+
 	template<typename... Args>
 	explicit binary_tree(Args&&... args) 
 		: root_{0}
@@ -87,8 +154,30 @@ public:
 		root_ = node(nodes_.emplace(std::forward<Args>(args)...)); 
 	}
 
+	explicit binary_tree(empty_binary_tree_t) : root_{ node::null_node() } {}
+
+	std::size_t size() const { return nodes_.size(); }
+	void reserve(std::size_t count) { nodes_.reserve(count); }
+
+	void clear()
+	{
+		nodes_ = registry<inner_type, Index>();
+		root_ = node::null_node();
+	}
+	
+	// All node indices are less than this value
+	std::size_t index_bound() const { return nodes_.id_bound(); }
+
 	node root() const { return root_; }
-	void set_root(const node& n) { root_ = n; }
+	void set_root(const node& n)
+	{
+		if constexpr (has_parent_links)
+		{
+			if (!n.is_null()) inner(n).reset_parent_index();
+		}
+
+		root_ = n;
+	}
 	
 	void remove_node(const node& n) { nodes_.erase(n.index()); }
 
@@ -104,49 +193,241 @@ public:
 	{ 
 		check_null_node(parent);
 		const auto current = nodes_.emplace(std::forward<Args>(args)...);
-		inner(parent).set_left_index(current);
+		set_left(parent, node(current));
 		return node(current);
 	}
 
 	node left(const node& n) const { return node(inner(n).left_index()); }
-	void reset_left(const node& n) { inner(n).reset_left_index(); }
-	void set_left(const node& parent, const node& left) { inner(parent).set_left_index(left.index()); }
+	void reset_left(const node& n) { set_left(n, node::null_node()); }
+	void set_left(const node& parent, const node& left)
+	{
+		const node old = this->left(parent);
+		relink_left(parent, left);
+		if constexpr (has_parent_links)
+		{
+			detach_child(parent, old);
+			if (!left.is_null()) inner(left).set_parent_index(parent.index());
+		}
+
+		if constexpr (has_order_statistics)
+			update_subtree_sizes(parent, old, left);
+	}
 
 	template<typename... Args>
 	node emplace_right(const node& parent, Args&&... args)
 	{
 		check_null_node(parent);
 		const auto current = nodes_.emplace(std::forward<Args>(args)...);
-		inner(parent).set_right_index(current);
+		set_right(parent, node(current));
 		return node(current);
 	}
 
 	node right(const node& n) const { return node(inner(n).right_index()); }
-	void reset_right(const node& n) { inner(n).reset_right_index(); }
-	void set_right(const node& parent, const node& right) { inner(parent).set_right_index(right.index()); }
+	void reset_right(const node& n) { set_right(n, node::null_node()); }
+	void set_right(const node& parent, const node& right)
+	{
+		const node old = this->right(parent);
+		relink_right(parent, right);
+		if constexpr (has_parent_links)
+		{
+			detach_child(parent, old);
+			if (!right.is_null()) inner(right).set_parent_index(parent.index());
+		}
+
+		if constexpr (has_order_statistics)
+			update_subtree_sizes(parent, old, right);
+	}
+
+	node parent(const node& n) const
+	{
+		static_assert(has_parent_links, "binary_tree has to be augmented with parent links");
+		return node(inner(n).parent_index());
+	}
+
+	// Change child links without updating parent links.
+	// Used by Morris traversals which temporarily rewire the tree and restore it afterwards.
+	void relink_left(const node& parent, const node& left) { inner(parent).set_left_index(left.index()); }
+	void relink_right(const node& parent, const node& right) { inner(parent).set_right_index(right.index()); }
 
 	const T& value(const node& n) const { return inner(n).value(); }
 	T& value(const node& n) { return const_cast<T&>(const_cast<const binary_tree*>(this)->value(n)); }
 
+	// Height slot of binary_tree_augmentation::heights, new nodes start with 1 and
+	// the owner of the tree keeps it up to date. Null node has height 0.
+	int subtree_height(const node& n) const
+	{
+		static_assert(has_heights, "binary_tree has to be augmented with heights");
+		return n.is_null() ? 0 : inner(n).height();
+	}
+
+	void set_subtree_height(const node& n, int height)
+	{
+		static_assert(has_heights, "binary_tree has to be augmented with heights");
+		inner(n).set_height(height);
+	}
+
+	// With binary_tree_augmentation::order_statistics subtree sizes are maintained
+	// by set_left/set_right (and emplace_left/emplace_right) at O(height) cost per call.
+	std::size_t subtree_size(const node& n) const
+	{
+		static_assert(has_order_statistics, "binary_tree has to be augmented with order statistics");
+		return n.is_null() ? 0 : inner(n).subtree_size();
+	}
+
+	// Node at position k (from zero) in inorder traversal of the root subtree, null node if k is out of range
+	node select(std::size_t k) const
+	{
+		node current = root_;
+		while (!current.is_null())
+		{
+			const std::size_t leftSize = subtree_size(left(current));
+			if (k == leftSize) return current;
+
+			if (k < leftSize)
+			{
+				current = left(current);
+			}
+			else
+			{
+				k -= leftSize + 1;
+				current = right(current);
+			}
+		}
+
+		return current;
+	}
+
+	// Position of the node in inorder traversal of the tree containing it
+	std::size_t rank(const node& n) const
+	{
+		std::size_t result = subtree_size(left(n));
+		for (node current = n, p = parent(n); !p.is_null(); current = p, p = parent(p))
+		{
+			if (right(p) == current)
+				result += subtree_size(left(p)) + 1;
+		}
+
+		return result;
+	}
+
+	// Hint that node is going to be accessed soon
+	void prefetch(const node& n) const { if (!n.is_null()) nodes_.prefetch(n.index()); }
+
+	// Rebuilds storage placing nodes reachable from root in breadth-first (Eytzinger)
+	// or van Emde Boas order. Unreachable nodes are dropped, all node handles are invalidated.
+	node relayout(binary_tree_layout layout)
+	{
+		std::vector<node> order;
+		if (!root_.is_null())
+		{
+			if (layout == binary_tree_layout::eytzinger) breadth_first_order(order);
+			else van_emde_boas_order(root_, height(), order);
+		}
+
+		std::vector<Index> indices(nodes_.id_bound(), binary_tree_impl::inner_node<Index>::null_node_index);
+		for (std::size_t i = 0; i < std::size(order); ++i)
+			indices[order[i].index()] = static_cast<Index>(i);
+
+		const auto relocate = [&indices](Index index) {
+			return index == binary_tree_impl::inner_node<Index>::null_node_index ? index : indices[index];
+		};
+
+		registry<inner_type, Index> relaid;
+		relaid.reserve(std::size(order));
+		for (const node n : order)
+		{
+			auto& moved = relaid.value(relaid.emplace(std::move(inner(n))));
+			moved.set_left_index(relocate(moved.left_index()));
+			moved.set_right_index(relocate(moved.right_index()));
+			if constexpr (has_parent_links)
+				moved.set_parent_index(relocate(moved.parent_index()));
+		}
+
+		nodes_ = std::move(relaid);
+		root_ = order.empty() ? node::null_node() : node(0);
+		return root_;
+	}
+
 private:
+	std::size_t height() const
+	{
+		std::size_t result = 0;
+		for (std::vector<node> level{ root_ }, next; !level.empty(); level.swap(next), next.clear(), ++result)
+			append_children(level, next);
+
+		return result;
+	}
+
+	void append_children(const std::vector<node>& level, std::vector<node>& next) const
+	{
+		for (const node n : level)
+		{
+			if (const node l = left(n); !l.is_null()) next.emplace_back(l);
+			if (const node r = right(n); !r.is_null()) next.emplace_back(r);
+		}
+	}
+
+	void breadth_first_order(std::vector<node>& order) const
+	{
+		order.emplace_back(root_);
+		for (std::size_t i = 0; i < std::size(order); ++i)
+		{
+			if (const node l = left(order[i]); !l.is_null()) order.emplace_back(l);
+			if (const node r = right(order[i]); !r.is_null()) order.emplace_back(r);
+		}
+	}
+
+	// Top half of the levels is laid out first, then every bottom subtree, recursively
+	void van_emde_boas_order(const node& n, std::size_t levels, std::vector<node>& order) const
+	{
+		if (levels == 1)
+		{
+			order.emplace_back(n);
+			return;
+		}
+
+		const std::size_t top = levels / 2;
+		van_emde_boas_order(n, top, order);
+
+		std::vector<node> level{ n }, next;
+		for (std::size_t i = 0; i < top; ++i, level.swap(next), next.clear())
+			append_children(level, next);
+
+		for (const node bottom : level)
+			van_emde_boas_order(bottom, levels - top, order);
+	}
+
 	void check_null_node(const node& n) const { if (n.is_null()) throw std::runtime_error("node was null");  }
 
-	const binary_tree_impl::inner_data_node<T>& inner(const node& n) const { check_null_node(n); return nodes_.value(n.index()); }
-	binary_tree_impl::inner_data_node<T>& inner(const node& n)
+	void update_subtree_sizes(const node& parent, const node& oldChild, const node& newChild)
 	{
-		return const_cast<binary_tree_impl::inner_data_node<T>&>(const_cast<const binary_tree*>(this)->inner(n));
+		if (oldChild == newChild) return;
+
+		// Unsigned wraparound turns the difference into a decrement when subtree shrinks
+		const auto delta = static_cast<Index>(subtree_size(newChild) - subtree_size(oldChild));
+		for (node current = parent; !current.is_null(); current = this->parent(current))
+			inner(current).set_subtree_size(static_cast<Index>(inner(current).subtree_size() + delta));
 	}
 
+	void detach_child(const node& parent, const node& child)
+	{
+		if (!child.is_null() && inner(child).parent_index() == parent.index())
+			inner(child).reset_parent_index();
+	}
+
+	const inner_type& inner(const node& n) const { check_null_node(n); return nodes_.value(n.index()); }
+	inner_type& inner(const node& n) { return const_cast<inner_type&>(const_cast<const binary_tree*>(this)->inner(n)); }
+
 private:
 	node root_;
-	registry<binary_tree_impl::inner_data_node<T>> nodes_;
+	registry<inner_type, Index> nodes_;
 };
 
 
-template<typename T, typename Func>
-void traverse_preorder(const binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_preorder(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
-	using node_type = typename binary_tree<T>::node;
+	using node_type = typename binary_tree<T, Index, Augmentation>::node;
 
 	std::vector<node_type> nodes;
 	nodes.emplace_back(root);
@@ -166,16 +447,16 @@ void traverse_preorder(const binary_tree<T>& tr, typename binary_tree<T>::node r
 	}
 }
 
-template<typename T, typename Func>
-void traverse_preorder(binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_preorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
-	traverse_preorder(const_cast<const binary_tree<T>&>(tr), root,
+	traverse_preorder(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
 		[f = std::forward<Func>(func) ](const T& value) { f(const_cast<T&>(value)); });
 }
 
 
-template<typename T, typename Func>
-void traverse_preorder_recursive(const binary_tree<T>& tr, typename binary_tree<T>::node root, Func func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_preorder_recursive(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func func)
 {
 	if (root.is_null()) return;
 
@@ -184,17 +465,19 @@ void traverse_preorder_recursive(const binary_tree<T>& tr, typename binary_tree<
 	traverse_preorder_recursive(tr, tr.right(root), func);
 }
 
-template<typename T, typename Func>
-void traverse_preorder_recursive(binary_tree<T>& tr, typename binary_tree<T>::node root, Func func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_preorder_recursive(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func func)
 {
-	traverse_preorder_recursive(const_cast<const binary_tree<T>&>(tr), root, 
+	traverse_preorder_recursive(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root, 
 		[func](const T& value) { func(const_cast<T&>(value)); });
 }
 
 
-template<typename T, typename Func>
-void morris_traversal_preorder(binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void morris_traversal_preorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
+	using node_type = typename binary_tree<T, Index, Augmentation>::node;
+
 	while (!root.is_null())
 	{
 		auto left = tr.left(root);
@@ -218,7 +501,7 @@ void morris_traversal_preorder(binary_tree<T>& tr, typename binary_tree<T>::node
 			{
 				// If the right child of inorder predecessor 
 				// already points to this node
-				tr.reset_right(predecessor);
+				tr.relink_right(predecessor, node_type::null_node());
 				root = tr.right(root);
 			}
 			else
@@ -226,7 +509,7 @@ void morris_traversal_preorder(binary_tree<T>& tr, typename binary_tree<T>::node
 				// If right child doesn't point to this node, then print this  
 				// node and make right child point to this node
 				func(tr.value(root));
-				tr.set_right(predecessor, root);
+				tr.relink_right(predecessor, root);
 				root = tr.left(root);
 			}
 		}
@@ -234,10 +517,10 @@ void morris_traversal_preorder(binary_tree<T>& tr, typename binary_tree<T>::node
 }
 
 
-template<typename T, typename Func>
-void traverse_inorder(const binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_inorder(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
-	using node_type = typename binary_tree<T>::node;
+	using node_type = typename binary_tree<T, Index, Augmentation>::node;
 
 	std::vector<node_type> nodes;
 	while (!(root.is_null() && nodes.empty()))
@@ -260,17 +543,19 @@ void traverse_inorder(const binary_tree<T>& tr, typename binary_tree<T>::node ro
 	}
 }
 
-template<typename T, typename Func>
-void traverse_inorder(binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_inorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
-	traverse_inorder(const_cast<const binary_tree<T>&>(tr), root,
+	traverse_inorder(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
 		[f = std::forward<Func>(func)](const T& value) { f(const_cast<T&>(value)); });
 }
 
 
-template<typename T, typename Func>
-void morris_traversal_inorder(binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void morris_traversal_inorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
+	using node_type = typename binary_tree<T, Index, Augmentation>::node;
+
 	while (!root.is_null())
 	{
 		auto left = tr.left(root);
@@ -293,14 +578,14 @@ void morris_traversal_inorder(binary_tree<T>& tr, typename binary_tree<T>::node
 			if (right.is_null())
 			{
 				// Make current as the right child of its inorder predecessor
-				tr.set_right(predecessor, root);
+				tr.relink_right(predecessor, root);
 				root = tr.left(root);
 			}
 			else
 			{
 				// Revert the changes made in the 'if' part to restore
 				// the original tree i.e., fix the right child of predecessor
-				tr.reset_right(predecessor);
+				tr.relink_right(predecessor, node_type::null_node());
 				func(tr.value(root));
 				root = tr.right(root);
 			}
@@ -309,8 +594,8 @@ void morris_traversal_inorder(binary_tree<T>& tr, typename binary_tree<T>::node
 }
 
 
-template<typename T, typename Func>
-void traverse_inorder_recursive(const binary_tree<T>& tr, const typename binary_tree<T>::node& root, Func func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_inorder_recursive(const binary_tree<T, Index, Augmentation>& tr, const typename binary_tree<T, Index, Augmentation>::node& root, Func func)
 {
 	if (root.is_null()) return;
 
@@ -319,18 +604,18 @@ void traverse_inorder_recursive(const binary_tree<T>& tr, const typename binary_
 	traverse_inorder(tr, tr.right(root), func);
 }
 
-template<typename T, typename Func>
-void traverse_inorder_recursive(binary_tree<T>& tr, const typename binary_tree<T>::node& root, Func func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_inorder_recursive(binary_tree<T, Index, Augmentation>& tr, const typename binary_tree<T, Index, Augmentation>::node& root, Func func)
 {
-	traverse_inorder_recursive(const_cast<const binary_tree<T>&>(tr), root,
+	traverse_inorder_recursive(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
 		[func](const T& value) { func(const_cast<T&>(value)); });
 }
 
 
-template<typename T, typename Func>
-void traverse_postorder(const binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_postorder(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
-	using node_type = typename binary_tree<T>::node;
+	using node_type = typename binary_tree<T, Index, Augmentation>::node;
 
 	std::vector<node_type> nodes;
 	while (!(root.is_null() && nodes.empty()))
@@ -367,36 +652,67 @@ void traverse_postorder(const binary_tree<T>& tr, typename binary_tree<T>::node
 	}
 }
 
-template<typename T, typename Func>
-void traverse_postorder(binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_postorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
 {
-	traverse_postorder(const_cast<const binary_tree<T>&>(tr), root,
+	traverse_postorder(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
 		[f = std::forward<Func>(func)](const T& value) { f(const_cast<T&>(value)); });
 }
 
 
-template<typename T, typename Func>
-void morris_traversal_postorder(binary_tree<T>& tr, Func&& func)
+namespace binary_tree_impl
 {
-	const auto r = tr.root();
-	if (r.is_null()) return;
 
-	auto root = tr.emplace_root(T());
-	tr.set_left(root, r);
+	// Reverses right links from 'from' up to 'sentinel', visits the chain
+	// backwards and restores the links on the way
+	template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+	void visit_right_chain_reversed(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node from, typename binary_tree<T, Index, Augmentation>::node sentinel, Func& func)
+	{
+		auto first = sentinel;
+		auto middle = from;
+		while (middle != sentinel)
+		{
+			auto last = tr.right(middle);
+			tr.relink_right(middle, first);
+			first = middle;
+			middle = last;
+		}
 
-	while (!root.is_null())
+		middle = first;
+		first = sentinel;
+		while (middle != sentinel)
+		{
+			func(tr.value(middle));
+			auto last = tr.right(middle);
+			tr.relink_right(middle, first);
+			first = middle;
+			middle = last;
+		}
+	}
+
+}
+
+// Doesn't allocate and doesn't need a sentinel node, the right spine
+// of root is visited last as if root were the left child of a dummy node
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void morris_traversal_postorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	using node_type = typename binary_tree<T, Index, Augmentation>::node;
+
+	auto current = root;
+	while (!current.is_null())
 	{
-		auto left = tr.left(root);
+		auto left = tr.left(current);
 		if (left.is_null())
 		{
-			root = tr.right(root);
+			current = tr.right(current);
 		}
 		else
 		{
 			// Find the inorder predecessor of current
 			auto predecessor = left;
 			auto right = tr.right(predecessor);
-			while (!(right.is_null() || right == root))
+			while (!(right.is_null() || right == current))
 			{
 				predecessor = right;
 				right = tr.right(right);
@@ -405,51 +721,34 @@ void morris_traversal_postorder(binary_tree<T>& tr, Func&& func)
 			if (right.is_null())
 			{
 				// Make current as the right child of its inorder predecessor
-				tr.set_right(predecessor, root);
-				root = tr.left(root);
+				tr.relink_right(predecessor, current);
+				current = tr.left(current);
 			}
 			else
 			{
-				// predecessor found second time
-				// reverse the right refernces in chain from pred to p
-				auto first = root;
-				auto middle = tr.left(root);
-				while (middle != root)
-				{
-					auto last = tr.right(middle);
-					tr.set_right(middle, first);
-					first = middle;
-					middle = last;
-				}
-
-				// visit the nodes from pred to p
-				// again reverse the right references from pred to p
-				first = root;
-				middle = predecessor;
-				while (middle != root)
-				{
-					func(tr.value(middle));
-					auto last = tr.right(middle);
-					tr.set_right(middle, first);
-					first = middle;
-					middle = last;
-				}
+				// predecessor found second time, visit the chain from predecessor to left child
+				binary_tree_impl::visit_right_chain_reversed(tr, left, current, func);
 
 				// Revert the changes made in the 'if' part to restore
 				// the original tree i.e., fix the right child of predecessor
-				tr.reset_right(predecessor);
-				root = tr.right(root);
+				tr.relink_right(predecessor, node_type::null_node());
+				current = tr.right(current);
 			}
 		}
 	}
 
-	tr.remove_node(root);
-	tr.set_root(r);
+	binary_tree_impl::visit_right_chain_reversed(tr, root, node_type::null_node(), func);
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void morris_traversal_postorder(binary_tree<T, Index, Augmentation>& tr, Func&& func)
+{
+	morris_traversal_postorder(tr, tr.root(), std::forward<Func>(func));
 }
 
 
-template<typename T, typename Func>
-void traverse_postorder_recursive(const binary_tree<T>& tr, typename binary_tree<T>::node root, Func func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_postorder_recursive(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func func)
 {
 	if (root.is_null()) return;
 
@@ -458,42 +757,497 @@ void traverse_postorder_recursive(const binary_tree<T>& tr, typename binary_tree
 	func(tr.value(root));
 }
 
-template<typename T, typename Func>
-void traverse_postorder_recursive(binary_tree<T>& tr, typename binary_tree<T>::node root, Func func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_postorder_recursive(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func func)
 {
-	traverse_postorder_recursive(const_cast<const binary_tree<T>&>(tr), root,
+	traverse_postorder_recursive(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
 		[func](const T& value) { func(const_cast<T&>(value)); });
 }
 
 
-template<typename T, typename Func>
-void traverse_depth_first(const binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+// Storage reused between level-order traversals to avoid allocation per call
+template<typename T, typename Index = std::size_t, binary_tree_augmentation Augmentation = binary_tree_augmentation::none>
+class binary_tree_level_buffer
 {
-	using node_type = typename binary_tree<T>::node;
+public:
+	using node = typename binary_tree<T, Index, Augmentation>::node;
+
+	std::vector<node> current;
+	std::vector<node> next;
+};
 
+
+/*
+	Level-order traversal processing whole levels at once.
+	func(depth, first, last) receives nodes of each level as contiguous range,
+	children of the level are prefetched while the next level is collected.
+*/
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename LevelFunc>
+void traverse_levels(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, LevelFunc&& func, binary_tree_level_buffer<T, Index, Augmentation>& buffer)
+{
+	buffer.current.clear();
+	buffer.next.clear();
 	if (root.is_null()) return;
 
-	std::queue<node_type> children;
-	children.emplace(root);
-	while (!children.empty())
+	buffer.current.emplace_back(root);
+	for (std::size_t depth = 0; !buffer.current.empty(); ++depth)
 	{
-		node_type current = children.front();
-		children.pop();
+		for (const auto n : buffer.current)
+		{
+			const auto left = tr.left(n);
+			const auto right = tr.right(n);
+			tr.prefetch(left);
+			tr.prefetch(right);
 
-		func(tr.value(current));
+			if (!left.is_null()) buffer.next.emplace_back(left);
+			if (!right.is_null()) buffer.next.emplace_back(right);
+		}
 
-		node_type left = tr.left(current);
-		if (!left.is_null()) children.emplace(left);
+		func(depth, std::cbegin(buffer.current), std::cend(buffer.current));
 
-		node_type right = tr.right(current);
-		if (!right.is_null()) children.emplace(right);
+		buffer.current.swap(buffer.next);
+		buffer.next.clear();
 	}
 }
 
-template<typename T, typename Func>
-void traverse_depth_first(binary_tree<T>& tr, typename binary_tree<T>::node root, Func&& func)
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename LevelFunc>
+void traverse_levels(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, LevelFunc&& func)
 {
-	traverse_depth_first(const_cast<const binary_tree<T>&>(tr), root,
+	binary_tree_level_buffer<T, Index, Augmentation> buffer;
+	traverse_levels(tr, root, std::forward<LevelFunc>(func), buffer);
+}
+
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_depth_first(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	traverse_levels(tr, root, [&tr, &func](std::size_t, auto first, auto last) {
+		for (; first != last; ++first)
+			func(tr.value(*first));
+	});
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void traverse_depth_first(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	traverse_depth_first(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
 		[f = std::forward<Func>(func)](const T& value) { f(const_cast<T&>(value)); });
 }
 
+
+
+namespace binary_tree_impl
+{
+
+	// Walks subtree of root following parent links, never modifies the tree.
+	template<typename T, typename Index, binary_tree_augmentation Augmentation, typename PreFunc, typename InFunc, typename PostFunc>
+	void stackless_traversal(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, PreFunc&& pre, InFunc&& in, PostFunc&& post)
+	{
+		if (root.is_null()) return;
+
+		auto prev = tr.parent(root);
+		auto current = root;
+		while (true)
+		{
+			const auto left = tr.left(current);
+			const auto right = tr.right(current);
+			auto next = tr.parent(current);
+
+			if (prev == tr.parent(current))
+			{
+				pre(tr.value(current));
+				if (!left.is_null())
+				{
+					next = left;
+				}
+				else
+				{
+					in(tr.value(current));
+					if (!right.is_null()) next = right;
+					else post(tr.value(current));
+				}
+			}
+			else if (prev == left)
+			{
+				in(tr.value(current));
+				if (!right.is_null()) next = right;
+				else post(tr.value(current));
+			}
+			else
+			{
+				post(tr.value(current));
+			}
+
+			if (next == tr.parent(current) && current == root)
+				break;
+
+			prev = current;
+			current = next;
+		}
+	}
+
+	struct skip_value { template<typename T> void operator()(const T&) const {} };
+
+}
+
+
+/*
+	Stackless traversals which follow parent links instead of rewriting
+	child links as Morris traversals do. They use O(1) extra space, never
+	mutate the tree, so concurrent readers can walk a shared tree.
+	Tree has to be augmented with binary_tree_augmentation::parent_links.
+*/
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void stackless_traversal_preorder(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	binary_tree_impl::stackless_traversal(tr, root, func, binary_tree_impl::skip_value(), binary_tree_impl::skip_value());
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void stackless_traversal_preorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	stackless_traversal_preorder(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
+		[f = std::forward<Func>(func)](const T& value) { f(const_cast<T&>(value)); });
+}
+
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void stackless_traversal_inorder(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	binary_tree_impl::stackless_traversal(tr, root, binary_tree_impl::skip_value(), func, binary_tree_impl::skip_value());
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void stackless_traversal_inorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	stackless_traversal_inorder(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
+		[f = std::forward<Func>(func)](const T& value) { f(const_cast<T&>(value)); });
+}
+
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void stackless_traversal_postorder(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	binary_tree_impl::stackless_traversal(tr, root, binary_tree_impl::skip_value(), binary_tree_impl::skip_value(), func);
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void stackless_traversal_postorder(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func&& func)
+{
+	stackless_traversal_postorder(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
+		[f = std::forward<Func>(func)](const T& value) { f(const_cast<T&>(value)); });
+}
+
+
+/*
+	Search in binary search tree ordered by comp.
+	Branch selection compiles to conditional moves and both children are
+	prefetched while the current node is compared, which pays off best
+	after binary_tree::relayout.
+*/
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Key, typename Compare = std::less<>>
+typename binary_tree<T, Index, Augmentation>::node binary_search_lower_bound(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, const Key& key, Compare comp = Compare())
+{
+	auto result = binary_tree<T, Index, Augmentation>::node::null_node();
+	while (!root.is_null())
+	{
+		const auto left = tr.left(root);
+		const auto right = tr.right(root);
+		tr.prefetch(left);
+		tr.prefetch(right);
+
+		const bool less = comp(tr.value(root), key);
+		result = less ? result : root;
+		root = less ? right : left;
+	}
+
+	return result;
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Key, typename Compare = std::less<>>
+typename binary_tree<T, Index, Augmentation>::node binary_search_find(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, const Key& key, Compare comp = Compare())
+{
+	const auto result = binary_search_lower_bound(tr, root, key, comp);
+	return (result.is_null() || comp(key, tr.value(result))) ? binary_tree<T, Index, Augmentation>::node::null_node() : result;
+}
+
+
+enum class binary_tree_order { preorder, inorder, postorder };
+
+namespace binary_tree_impl
+{
+
+	// Lazy traversal iterator, moves along parent links so it needs no stack
+	// and stops as soon as iteration stops. Tree may be const qualified.
+	template<typename Tree, binary_tree_order Order>
+	class traversal_iterator
+	{
+		using node = typename std::remove_const_t<Tree>::node;
+	public:
+		using value_type = typename std::remove_const_t<Tree>::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<std::is_const_v<Tree>, const value_type*, value_type*>;
+		using reference = std::conditional_t<std::is_const_v<Tree>, const value_type&, value_type&>;
+		using iterator_category = std::forward_iterator_tag;
+
+		traversal_iterator() : tree_{ nullptr }, root_{ node::null_node() }, current_{ node::null_node() } {}
+		explicit traversal_iterator(Tree* tr, node root, node current)
+			: tree_{ tr }, root_{ root }, current_{ current }
+		{}
+
+		node base() const { return current_; }
+
+		reference operator*() const { return tree_->value(current_); }
+		pointer operator->() const { return &tree_->value(current_); }
+
+		traversal_iterator& operator++()
+		{
+			if constexpr (Order == binary_tree_order::preorder) current_ = next_preorder(*tree_, root_, current_);
+			else if constexpr (Order == binary_tree_order::inorder) current_ = next_inorder(*tree_, root_, current_);
+			else current_ = next_postorder(*tree_, root_, current_);
+
+			return *this;
+		}
+
+		traversal_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+
+		friend bool operator==(const traversal_iterator& lhs, const traversal_iterator& rhs) { return lhs.current_ == rhs.current_; }
+		friend bool operator!=(const traversal_iterator& lhs, const traversal_iterator& rhs) { return !(lhs == rhs); }
+
+		static node first(const Tree& tr, node root)
+		{
+			if (root.is_null()) return root;
+			if constexpr (Order == binary_tree_order::preorder) return root;
+			else if constexpr (Order == binary_tree_order::inorder) return leftmost(tr, root);
+			else return first_postorder(tr, root);
+		}
+
+	private:
+		static node leftmost(const Tree& tr, node n)
+		{
+			for (node left = tr.left(n); !left.is_null(); left = tr.left(n)) n = left;
+			return n;
+		}
+
+		static node first_postorder(const Tree& tr, node n)
+		{
+			while (true)
+			{
+				if (const node left = tr.left(n); !left.is_null()) n = left;
+				else if (const node right = tr.right(n); !right.is_null()) n = right;
+				else return n;
+			}
+		}
+
+		static node next_preorder(const Tree& tr, node root, node n)
+		{
+			if (const node left = tr.left(n); !left.is_null()) return left;
+			if (const node right = tr.right(n); !right.is_null()) return right;
+
+			for (; n != root; n = tr.parent(n))
+			{
+				const node parent = tr.parent(n);
+				const node right = tr.right(parent);
+				if (right != n && !right.is_null()) return right;
+			}
+
+			return node::null_node();
+		}
+
+		static node next_inorder(const Tree& tr, node root, node n)
+		{
+			if (const node right = tr.right(n); !right.is_null()) return leftmost(tr, right);
+
+			for (; n != root; n = tr.parent(n))
+			{
+				const node parent = tr.parent(n);
+				if (tr.left(parent) == n) return parent;
+			}
+
+			return node::null_node();
+		}
+
+		static node next_postorder(const Tree& tr, node root, node n)
+		{
+			if (n == root) return node::null_node();
+
+			const node parent = tr.parent(n);
+			const node right = tr.right(parent);
+			return (right != n && !right.is_null()) ? first_postorder(tr, right) : parent;
+		}
+
+	private:
+		Tree* tree_;
+		node root_;
+		node current_;
+	};
+
+	// Lazy traversal iterator for trees without parent links, keeps the path
+	// to the current node on a stack of O(height) nodes. Tree may be const qualified.
+	template<typename Tree, binary_tree_order Order>
+	class stack_traversal_iterator
+	{
+		using node = typename std::remove_const_t<Tree>::node;
+	public:
+		using value_type = typename std::remove_const_t<Tree>::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<std::is_const_v<Tree>, const value_type*, value_type*>;
+		using reference = std::conditional_t<std::is_const_v<Tree>, const value_type&, value_type&>;
+		using iterator_category = std::forward_iterator_tag;
+
+		stack_traversal_iterator() : tree_{ nullptr }, current_{ node::null_node() } {}
+		explicit stack_traversal_iterator(Tree* tr, node root) : tree_{ tr }, current_{ node::null_node() }
+		{
+			if (root.is_null()) return;
+
+			if constexpr (Order == binary_tree_order::preorder) current_ = root;
+			else if constexpr (Order == binary_tree_order::inorder) current_ = push_leftmost(root);
+			else current_ = push_first_postorder(root);
+		}
+
+		node base() const { return current_; }
+
+		reference operator*() const { return tree_->value(current_); }
+		pointer operator->() const { return &tree_->value(current_); }
+
+		stack_traversal_iterator& operator++()
+		{
+			if constexpr (Order == binary_tree_order::preorder)
+			{
+				// Pending right subtrees wait on the stack
+				if (const node right = tree_->right(current_); !right.is_null()) nodes_.emplace_back(right);
+				if (const node left = tree_->left(current_); !left.is_null()) current_ = left;
+				else current_ = pop();
+			}
+			else if constexpr (Order == binary_tree_order::inorder)
+			{
+				// Stack holds ancestors whose left subtree is being visited
+				const node right = tree_->right(current_);
+				current_ = right.is_null() ? pop() : push_leftmost(right);
+			}
+			else
+			{
+				// Stack holds all ancestors of the current node
+				if (nodes_.empty())
+				{
+					current_ = node::null_node();
+				}
+				else
+				{
+					const node parent = nodes_.back();
+					const node right = tree_->right(parent);
+					if (right != current_ && !right.is_null())
+					{
+						current_ = push_first_postorder(right);
+					}
+					else
+					{
+						current_ = parent;
+						nodes_.pop_back();
+					}
+				}
+			}
+
+			return *this;
+		}
+
+		stack_traversal_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+
+		friend bool operator==(const stack_traversal_iterator& lhs, const stack_traversal_iterator& rhs) { return lhs.current_ == rhs.current_; }
+		friend bool operator!=(const stack_traversal_iterator& lhs, const stack_traversal_iterator& rhs) { return !(lhs == rhs); }
+
+	private:
+		node pop()
+		{
+			if (nodes_.empty()) return node::null_node();
+
+			const node result = nodes_.back();
+			nodes_.pop_back();
+			return result;
+		}
+
+		// Pushes n and its left chain, returns the leftmost node popped back
+		node push_leftmost(node n)
+		{
+			for (; !n.is_null(); n = tree_->left(n))
+				nodes_.emplace_back(n);
+
+			return pop();
+		}
+
+		// Pushes the path to the first postorder node of n's subtree, returns that node
+		node push_first_postorder(node n)
+		{
+			while (true)
+			{
+				if (const node left = tree_->left(n); !left.is_null()) { nodes_.emplace_back(n); n = left; }
+				else if (const node right = tree_->right(n); !right.is_null()) { nodes_.emplace_back(n); n = right; }
+				else return n;
+			}
+		}
+
+	private:
+		Tree* tree_;
+		node current_;
+		std::vector<node> nodes_;
+	};
+
+	template<typename Iter>
+	class traversal_range
+	{
+	public:
+		explicit traversal_range(Iter first, Iter last) : first_{ first }, last_{ last } {}
+
+		Iter begin() const { return first_; }
+		Iter end() const { return last_; }
+
+	private:
+		Iter first_;
+		Iter last_;
+	};
+
+	template<binary_tree_order Order, typename Tree>
+	auto make_traversal_range(Tree& tr, typename std::remove_const_t<Tree>::node root)
+	{
+		if constexpr (std::remove_const_t<Tree>::has_parent_links)
+		{
+			using iterator = traversal_iterator<Tree, Order>;
+			return traversal_range<iterator>(
+				iterator(&tr, root, iterator::first(tr, root)),
+				iterator(&tr, root, std::remove_const_t<Tree>::node::null_node()));
+		}
+		else
+		{
+			using iterator = stack_traversal_iterator<Tree, Order>;
+			return traversal_range<iterator>(iterator(&tr, root), iterator());
+		}
+	}
+
+}
+
+
+/*
+	Lazy ranges over subtree of root, iteration can be stopped at any moment
+	without visiting the rest of the tree. Iterators of trees with parent links
+	move along them in O(1) space, otherwise they keep a stack of O(height) nodes:
+
+		const auto r = inorder_range(tr, tr.root());
+		auto it = std::find_if(r.begin(), r.end(), pred);
+*/
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+auto preorder_range(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root) { return binary_tree_impl::make_traversal_range<binary_tree_order::preorder>(tr, root); }
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+auto preorder_range(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root) { return binary_tree_impl::make_traversal_range<binary_tree_order::preorder>(tr, root); }
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+auto inorder_range(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root) { return binary_tree_impl::make_traversal_range<binary_tree_order::inorder>(tr, root); }
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+auto inorder_range(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root) { return binary_tree_impl::make_traversal_range<binary_tree_order::inorder>(tr, root); }
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+auto postorder_range(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root) { return binary_tree_impl::make_traversal_range<binary_tree_order::postorder>(tr, root); }
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+auto postorder_range(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root) { return binary_tree_impl::make_traversal_range<binary_tree_order::postorder>(tr, root); }
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "binary_tree.hpp"
+#include "task_budget.hpp"
+
+#include <future>
+#include <thread>
+#include <utility>
+#include <algorithm>
+
+
+namespace binary_tree_impl
+{
+
+	// Forks until there are about four tasks per hardware thread
+	inline std::size_t default_fork_depth()
+	{
+		std::size_t depth = 2;
+		for (auto threads = std::max(1u, std::thread::hardware_concurrency()); threads > 1; threads /= 2)
+			++depth;
+
+		return depth;
+	}
+
+	// Subtrees smaller than this are never handed to another task when their size is known
+	constexpr std::size_t min_fork_size = 1024;
+
+	// Left subtree is forked only when both children exist, are not known to be small
+	// and the budget still has a free task
+	template<typename T, typename Index, binary_tree_augmentation Augmentation>
+	bool should_fork(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node left, typename binary_tree<T, Index, Augmentation>::node right, task_budget& budget)
+	{
+		if (left.is_null() || right.is_null()) return false;
+
+		if constexpr (binary_tree<T, Index, Augmentation>::has_order_statistics)
+		{
+			if (std::min(tr.subtree_size(left), tr.subtree_size(right)) < min_fork_size) return false;
+		}
+
+		return budget.acquire(1) == 1;
+	}
+
+	template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+	void fork_for_each(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func& func, task_budget& budget, std::size_t forkDepth)
+	{
+		if (root.is_null()) return;
+		if (forkDepth == 0)
+		{
+			traverse_preorder(tr, root, func);
+			return;
+		}
+
+		func(tr.value(root));
+
+		const auto left = tr.left(root);
+		const auto right = tr.right(root);
+		if (!should_fork(tr, left, right, budget))
+		{
+			fork_for_each(tr, left, func, budget, forkDepth - 1);
+			fork_for_each(tr, right, func, budget, forkDepth - 1);
+			return;
+		}
+
+		auto task = std::async(std::launch::async, [&tr, &func, &budget, forkDepth, left] {
+			task_budget_slot slot(budget);
+			fork_for_each(tr, left, func, budget, forkDepth - 1);
+		});
+
+		fork_for_each(tr, right, func, budget, forkDepth - 1);
+		task.get();
+	}
+
+	template<typename T, typename Index, binary_tree_augmentation Augmentation, typename R, typename Map, typename Combine>
+	R fork_reduce(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, const R& identity, Map& map, Combine& combine, task_budget& budget, std::size_t forkDepth)
+	{
+		if (root.is_null()) return identity;
+		if (forkDepth == 0)
+		{
+			R result = identity;
+			traverse_inorder(tr, root, [&](const T& value) { result = combine(std::move(result), map(value)); });
+			return result;
+		}
+
+		const auto left = tr.left(root);
+		const auto right = tr.right(root);
+		if (!should_fork(tr, left, right, budget))
+		{
+			R leftResult = fork_reduce(tr, left, identity, map, combine, budget, forkDepth - 1);
+			R middle = map(tr.value(root));
+			R rightResult = fork_reduce(tr, right, identity, map, combine, budget, forkDepth - 1);
+			return combine(combine(std::move(leftResult), std::move(middle)), std::move(rightResult));
+		}
+
+		auto task = std::async(std::launch::async, [&, left] {
+			task_budget_slot slot(budget);
+			return fork_reduce(tr, left, identity, map, combine, budget, forkDepth - 1);
+		});
+
+		R middle = map(tr.value(root));
+		R rightResult = fork_reduce(tr, right, identity, map, combine, budget, forkDepth - 1);
+		return combine(combine(task.get(), std::move(middle)), std::move(rightResult));
+	}
+
+}
+
+
+/*
+	Fork-join traversal: left and right subtrees are processed concurrently
+	down to forkDepth levels, deeper subtrees are traversed sequentially.
+	Left subtree is handed to a new task only while the traversal holds fewer tasks
+	than hardware threads, otherwise it runs inline. Trees with order statistics
+	also keep subtrees smaller than binary_tree_impl::min_fork_size inline.
+	func is called concurrently for different nodes and must be thread safe,
+	order of calls is unspecified.
+*/
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void parallel_for_each(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func func, std::size_t forkDepth = binary_tree_impl::default_fork_depth())
+{
+	task_budget budget(task_budget::hardware_tasks());
+	binary_tree_impl::fork_for_each(tr, root, func, budget, forkDepth);
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename Func>
+void parallel_for_each(binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, Func func, std::size_t forkDepth = binary_tree_impl::default_fork_depth())
+{
+	parallel_for_each(const_cast<const binary_tree<T, Index, Augmentation>&>(tr), root,
+		[&func](const T& value) { func(const_cast<T&>(value)); }, forkDepth);
+}
+
+
+/*
+	Fork-join reduction of map(value) over subtree of root.
+	Results are always combined in inorder, so the result is deterministic
+	and equals sequential left fold for any associative combine,
+	commutativity is not required.
+*/
+template<typename T, typename Index, binary_tree_augmentation Augmentation, typename R, typename Map, typename Combine>
+R parallel_reduce(const binary_tree<T, Index, Augmentation>& tr, typename binary_tree<T, Index, Augmentation>::node root, R identity, Map map, Combine combine, std::size_t forkDepth = binary_tree_impl::default_fork_depth())
+{
+	task_budget budget(task_budget::hardware_tasks());
+	return binary_tree_impl::fork_reduce(tr, root, identity, map, combine, budget, forkDepth);
+}
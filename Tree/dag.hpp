@@ -0,0 +1,234 @@
+#pragma once
+
+#include "graph.hpp"
+#include "registry.hpp"
+
+#include <vector>
+#include <cassert>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace dag_impl
+{
+
+	class inner_node
+	{
+	public:
+		explicit inner_node(std::size_t order) : order_{ order } {}
+
+		std::size_t order() const { return order_; }
+		void set_order(std::size_t order) { order_ = order; }
+
+		bool visited() const { return visited_; }
+		void set_visited(bool visited) { visited_ = visited; }
+
+		void add_successor(std::size_t nodeIndex)
+		{
+			assert(std::find(std::cbegin(successors_), std::cend(successors_), graph_node(nodeIndex)) == std::cend(successors_));
+			successors_.emplace_back(nodeIndex);
+		}
+
+		void add_predecessor(std::size_t nodeIndex)
+		{
+			assert(std::find(std::cbegin(predecessors_), std::cend(predecessors_), graph_node(nodeIndex)) == std::cend(predecessors_));
+			predecessors_.emplace_back(nodeIndex);
+		}
+
+		const std::vector<graph_node>& successors() const { return successors_; }
+		const std::vector<graph_node>& predecessors() const { return predecessors_; }
+
+	private:
+		std::size_t order_;
+		bool visited_ = false;
+		std::vector<graph_node> successors_;
+		std::vector<graph_node> predecessors_;
+	};
+
+	template<typename T>
+	class inner_data_node : public inner_node
+	{
+	public:
+		template<typename... Args>
+		explicit inner_data_node(std::size_t order, Args&&... args)
+			: inner_node(order)
+			, value_{ std::forward<Args>(args)... }
+		{}
+
+		T& value() { return value_; }
+		const T& value() const { return value_; }
+
+	private:
+		T value_;
+	};
+
+}
+
+
+/*
+	Directed acyclic graph which keeps its nodes in topological order.
+	The order is maintained incrementally with Pearce-Kelly algorithm:
+	inserting edge (from -> to) only visits nodes whose position lies
+	between positions of 'to' and 'from', so cycle check touches only
+	the affected region of the graph.
+*/
+template<typename T>
+class dag
+{
+public:
+	using node_iterator = std::vector<graph_node>::const_iterator;
+
+	template<typename... Args>
+	graph_node emplace_node(Args&&... args)
+	{
+		const graph_node result(nodes_.emplace(std::size(order_), std::forward<Args>(args)...));
+		order_.emplace_back(result);
+		return result;
+	}
+
+	// Adds edge (from -> to) if it doesn't create a cycle, returns false otherwise.
+	bool try_add_edge(const graph_node& from, const graph_node& to)
+	{
+		if (from == to) return false;
+
+		const std::size_t lowerBound = node_at(to.index()).order();
+		const std::size_t upperBound = node_at(from.index()).order();
+
+		if (lowerBound < upperBound)
+		{
+			std::vector<graph_node> forward;
+			if (!collect_forward(to, upperBound, forward))
+			{
+				reset_visited(forward);
+				return false;
+			}
+
+			std::vector<graph_node> backward;
+			collect_backward(from, lowerBound, backward);
+			reorder(forward, backward);
+		}
+
+		node_at(from.index()).add_successor(to.index());
+		node_at(to.index()).add_predecessor(from.index());
+		return true;
+	}
+
+	void add_edge(const graph_node& from, const graph_node& to)
+	{
+		if (!try_add_edge(from, to))
+			throw std::invalid_argument("edge creates a cycle");
+	}
+
+	// Position of the node in topological order
+	std::size_t order_of(const graph_node& n) const { return node_at(n.index()).order(); }
+	const std::vector<graph_node>& topological_order() const { return order_; }
+
+	const T& value_of(const graph_node& n) const { return nodes_.value(n.index()).value(); }
+	T& value_of(const graph_node& n) { return nodes_.value(n.index()).value(); }
+
+	node_iterator successors_begin(const graph_node& n) const { return std::cbegin(node_at(n.index()).successors()); }
+	node_iterator successors_end(const graph_node& n) const { return std::cend(node_at(n.index()).successors()); }
+
+	node_iterator predecessors_begin(const graph_node& n) const { return std::cbegin(node_at(n.index()).predecessors()); }
+	node_iterator predecessors_end(const graph_node& n) const { return std::cend(node_at(n.index()).predecessors()); }
+
+	const std::vector<graph_node>& successors_of(const graph_node& n) const { return node_at(n.index()).successors(); }
+	const std::vector<graph_node>& predecessors_of(const graph_node& n) const { return node_at(n.index()).predecessors(); }
+
+private:
+	// Visits nodes reachable from 'start' with order <= upperBound.
+	// Returns false if node with order == upperBound (the edge source) was reached.
+	bool collect_forward(const graph_node& start, std::size_t upperBound, std::vector<graph_node>& result)
+	{
+		std::vector<graph_node> stack{ start };
+		node_at(start.index()).set_visited(true);
+		while (!stack.empty())
+		{
+			const graph_node current = stack.back();
+			stack.pop_back();
+			result.emplace_back(current);
+
+			for (const graph_node next : node_at(current.index()).successors())
+			{
+				auto& inner = node_at(next.index());
+				if (inner.order() == upperBound)
+				{
+					reset_visited(stack);
+					return false;
+				}
+
+				if (!inner.visited() && inner.order() < upperBound)
+				{
+					inner.set_visited(true);
+					stack.emplace_back(next);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Visits nodes from which 'start' is reachable with order > lowerBound.
+	void collect_backward(const graph_node& start, std::size_t lowerBound, std::vector<graph_node>& result)
+	{
+		std::vector<graph_node> stack{ start };
+		node_at(start.index()).set_visited(true);
+		while (!stack.empty())
+		{
+			const graph_node current = stack.back();
+			stack.pop_back();
+			result.emplace_back(current);
+
+			for (const graph_node prev : node_at(current.index()).predecessors())
+			{
+				auto& inner = node_at(prev.index());
+				if (!inner.visited() && lowerBound < inner.order())
+				{
+					inner.set_visited(true);
+					stack.emplace_back(prev);
+				}
+			}
+		}
+	}
+
+	// Backward set must precede forward set, both keep their relative order.
+	// Nodes are placed into the pool of positions they occupied before.
+	void reorder(std::vector<graph_node>& forward, std::vector<graph_node>& backward)
+	{
+		const auto byOrder = [this](const graph_node& lhs, const graph_node& rhs) { return order_of(lhs) < order_of(rhs); };
+		std::sort(std::begin(forward), std::end(forward), byOrder);
+		std::sort(std::begin(backward), std::end(backward), byOrder);
+
+		std::vector<std::size_t> positions;
+		positions.reserve(std::size(forward) + std::size(backward));
+		for (const graph_node n : backward) positions.emplace_back(order_of(n));
+		for (const graph_node n : forward) positions.emplace_back(order_of(n));
+		std::inplace_merge(std::begin(positions), std::begin(positions) + std::size(backward), std::end(positions));
+
+		auto pos = std::cbegin(positions);
+		for (const auto* part : { &backward, &forward })
+		{
+			for (const graph_node n : *part)
+			{
+				auto& inner = node_at(n.index());
+				inner.set_order(*pos);
+				inner.set_visited(false);
+				order_[*pos] = n;
+				++pos;
+			}
+		}
+	}
+
+	void reset_visited(const std::vector<graph_node>& nodes)
+	{
+		for (const graph_node n : nodes)
+			node_at(n.index()).set_visited(false);
+	}
+
+	const dag_impl::inner_node& node_at(std::size_t index) const { return nodes_.value(index); }
+	dag_impl::inner_node& node_at(std::size_t index) { return nodes_.value(index); }
+
+private:
+	std::vector<graph_node> order_;
+	registry<dag_impl::inner_data_node<T>> nodes_;
+};
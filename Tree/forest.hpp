@@ -1,8 +1,22 @@
 #pragma once
 
+#include <new>
+#include <memory>
+#include <vector>
 #include <utility>
 #include <cassert>
 #include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+
+
+// Per-node data kept by forest besides the links
+enum class forest_augmentation
+{
+	none,
+	subtree_sizes	// parent pointer and count of nodes in the subtree
+};
 
 
 /*
@@ -12,7 +26,7 @@
 	This version of the forest class does not depend on the boost library. 
 	It also has slight differences from the original.
 */
-template<typename T>
+template<typename T, forest_augmentation Augmentation = forest_augmentation::none>
 class forest;
 
 enum class forest_edge { leading, trailing };
@@ -38,6 +52,11 @@ namespace forest_impl {
 			, trailing_(nodes_pair<NodeType>(static_cast<NodeType*>(this), static_cast<NodeType*>(this)))
 		{}
 
+		// Links belong to the object, not to its value: copies and moved-to objects start unlinked
+		// and assignment keeps the links of the target, whether it is linked or not.
+		forest_node_base(const forest_node_base&) : forest_node_base() {}
+		forest_node_base& operator=(const forest_node_base&) { return *this; }
+
 		nodes_pair<NodeType>& get(forest_edge e) { return e == forest_edge::leading ? leading_ : trailing_; }
 		const nodes_pair<NodeType>& get(forest_edge e) const { return e == forest_edge::leading ? leading_ : trailing_; }
 
@@ -47,40 +66,173 @@ namespace forest_impl {
 		const nodes_pair<NodeType>& leading() const { return leading_; }
 		const nodes_pair<NodeType>& trailing() const { return trailing_; }
 
+		// Node linked to itself is not a part of any forest
+		bool is_linked() const { return leading_.prev != static_cast<const NodeType*>(this); }
+		void reset()
+		{
+			leading_ = nodes_pair<NodeType>(static_cast<NodeType*>(this), static_cast<NodeType*>(this));
+			trailing_ = nodes_pair<NodeType>(static_cast<NodeType*>(this), static_cast<NodeType*>(this));
+		}
+
 	private:
 		nodes_pair<NodeType> leading_;
 		nodes_pair<NodeType> trailing_;
 	};
 
 
+	template<typename T, forest_augmentation Augmentation>
+	struct forest_node : forest_node_base<forest_node<T, Augmentation>>
+	{
+		template<typename... Args>
+		explicit forest_node(Args&&... args) : value(std::forward<Args>(args)...) { }
+
+		T value;
+	};
+
 	template<typename T>
-	struct forest_node : forest_node_base<forest_node<T>>
+	struct forest_node<T, forest_augmentation::subtree_sizes> : forest_node_base<forest_node<T, forest_augmentation::subtree_sizes>>
 	{
 		template<typename... Args>
 		explicit forest_node(Args&&... args) : value(std::forward<Args>(args)...) { }
 
 		T value;
+		// nullptr for roots
+		forest_node* parent = nullptr;
+		std::size_t subtree_size = 1;
+	};
+
+	// Moves (node, edge) pair to the next edge in full order
+	template<typename NodeType>
+	void increment_edge(NodeType*& n, forest_edge& edge)
+	{
+		if (edge == forest_edge::leading)
+		{
+			NodeType* next(n->leading().next);
+			if (next == n) edge = forest_edge::trailing;
+			n = next;
+		}
+		else // (edge == forest_edge::trailing)
+		{
+			NodeType* next(n->trailing().next);
+			if (next->leading().prev == n) edge = forest_edge::leading;
+			n = next;
+		}
+	}
+
+	// Moves (node, edge) pair to the previous edge in full order
+	template<typename NodeType>
+	void decrement_edge(NodeType*& n, forest_edge& edge)
+	{
+		if (edge == forest_edge::leading)
+		{
+			NodeType* prev(n->leading().prev);
+			if (prev->trailing().next == n) edge = forest_edge::trailing;
+			n = prev;
+		}
+		else // (edge == forest_edge::trailing)
+		{
+			NodeType* prev(n->trailing().prev);
+			if (prev == n) edge = forest_edge::leading;
+			n = prev;
+		}
+	}
+
+
+	/*
+		Allocates nodes from contiguous chunks of growing size.
+		Freed nodes are kept in intrusive free list, all chunks are released at once.
+	*/
+	template<typename Node>
+	class node_pool
+	{
+		union slot
+		{
+			slot* next;
+			typename std::aligned_storage<sizeof(Node), alignof(Node)>::type storage;
+		};
+
+		static constexpr std::size_t initial_chunk_size = 64;
+		static constexpr std::size_t max_chunk_size = 1 << 16;
+
+	public:
+		node_pool() = default;
+		node_pool(const node_pool&) = delete;
+		node_pool& operator=(const node_pool&) = delete;
+
+		void* allocate()
+		{
+			if (free_ != nullptr)
+			{
+				slot* result = free_;
+				free_ = free_->next;
+				return result;
+			}
+
+			if (current_ == end_) grow(chunkSize_);
+			return current_++;
+		}
+
+		void deallocate(void* p)
+		{
+			slot* freed = static_cast<slot*>(p);
+			freed->next = free_;
+			free_ = freed;
+		}
+
+		// Skips chunk growth steps up to count nodes. Chunks stay capped,
+		// so that released storage is reused by the allocator instead of being unmapped.
+		void reserve(std::size_t count)
+		{
+			if (static_cast<std::size_t>(end_ - current_) >= count) return;
+
+			chunkSize_ = std::min(std::max(count, chunkSize_), max_chunk_size);
+			grow(chunkSize_);
+		}
+
+		void release()
+		{
+			chunks_.clear();
+			free_ = current_ = end_ = nullptr;
+			chunkSize_ = initial_chunk_size;
+		}
+
+	private:
+		void grow(std::size_t count)
+		{
+			chunks_.emplace_back(new slot[count]);
+			current_ = chunks_.back().get();
+			end_ = current_ + count;
+			chunkSize_ = std::min(chunkSize_ * 2, max_chunk_size);
+		}
+
+	private:
+		std::vector<std::unique_ptr<slot[]>> chunks_;
+		slot* free_ = nullptr;
+		slot* current_ = nullptr;
+		slot* end_ = nullptr;
+		std::size_t chunkSize_ = initial_chunk_size;
 	};
 
+
 	template<typename Iter>
 	struct set_next_functor;
 
-	template<typename T>
+	template<typename T, forest_augmentation Augmentation>
 	class forest_const_iterator;
 
-	template<typename T>
+	template<typename T, forest_augmentation Augmentation>
 	class forest_iterator
 	{
-		using node = forest_node<T>;
+		using node = forest_node<T, Augmentation>;
 
-		friend struct set_next_functor<forest_iterator<T>>;
-		friend class forest<T>;
-		friend class forest_const_iterator<T>;
+		friend struct set_next_functor<forest_iterator<T, Augmentation>>;
+		friend class forest<T, Augmentation>;
+		friend class forest_const_iterator<T, Augmentation>;
 
 		explicit forest_iterator(node* node, forest_edge edge)
 			: node_{ node }, edge_{ edge } { assert(node != nullptr); }
 
-		forest_iterator(const forest_const_iterator<T>& other)
+		forest_iterator(const forest_const_iterator<T, Augmentation>& other)
 			: node_{ other.node_ }, edge_{ other.edge_ }{  }
 	public:
 
@@ -100,44 +252,20 @@ namespace forest_impl {
 		void make_leading() { edge_ = forest_edge::leading; }
 		void make_trailing() { edge_ = forest_edge::trailing; }
 
-		bool equal_node(const forest_iterator& other) const { return node_ == other.edge_; }
+		bool equal_node(const forest_iterator& other) const { return node_ == other.node_; }
 
 		T& operator*() const { return node_->value; }
 		T* operator->() const { return &(node_->value); }
 
 		forest_iterator& operator++()
 		{
-			if (edge_ == forest_edge::leading)
-			{
-				node* next(node_->leading().next);
-				if (next == node_) edge_ = forest_edge::trailing;
-				node_ = next;
-			}
-			else // (edge_ == forest_edge::trailing)
-			{
-				node* next(node_->trailing().next);
-				if(next->leading().prev == node_) edge_ = forest_edge::leading;
-				node_ = next;
-			}
-
+			forest_impl::increment_edge(node_, edge_);
 			return *this;
 		}
 
 		forest_iterator& operator--()
 		{
-			if (edge_ == forest_edge::leading)
-			{
-				node* prev(node_->leading().prev);
-				if (prev->trailing().next == node_) edge_ = forest_edge::trailing;
-				node_ = prev;
-			}
-			else // (edge_ == forest_edge::trailing)
-			{
-				node* prev(node_->trailing().prev);
-				if (prev == node_) edge_ = forest_edge::leading;
-				node_ = prev;
-			}
-
+			forest_impl::decrement_edge(node_, edge_);
 			return *this;
 		}
 
@@ -158,14 +286,14 @@ namespace forest_impl {
 		forest_edge edge_;
 	};
 
-	template<typename T>
+	template<typename T, forest_augmentation Augmentation>
 	class forest_const_iterator
 	{
-		using node = forest_node<T>;
+		using node = forest_node<T, Augmentation>;
 
-		friend struct set_next_functor<forest_const_iterator<T>>;
-		friend class forest<T>;
-		friend class forest_iterator<T>;
+		friend struct set_next_functor<forest_const_iterator<T, Augmentation>>;
+		friend class forest<T, Augmentation>;
+		friend class forest_iterator<T, Augmentation>;
 
 		explicit forest_const_iterator(node* node, forest_edge edge)
 			: node_{ node }, edge_{ edge } { assert(node != nullptr); }
@@ -178,7 +306,7 @@ namespace forest_impl {
 		using iterator_category = std::bidirectional_iterator_tag;
 
 		forest_const_iterator() : node_{ nullptr }, edge_{ forest_edge::leading } {}
-		forest_const_iterator(forest_iterator<T> other) : node_{ other.node_ }, edge_{ other.edge_ } {}
+		forest_const_iterator(forest_iterator<T, Augmentation> other) : node_{ other.node_ }, edge_{ other.edge_ } {}
 
 		forest_edge edge() const { return edge_; }
 
@@ -195,37 +323,13 @@ namespace forest_impl {
 
 		forest_const_iterator& operator++()
 		{
-			if (edge_ == forest_edge::leading)
-			{
-				node* next(node_->leading().next);
-				if (next == node_) edge_ = forest_edge::trailing;
-				node_ = next;
-			}
-			else // (edge_ == forest_edge::trailing)
-			{
-				node* next(node_->trailing().next);
-				if (next->leading().prev == node_) edge_ = forest_edge::leading;
-				node_ = next;
-			}
-
+			forest_impl::increment_edge(node_, edge_);
 			return *this;
 		}
 
 		forest_const_iterator& operator--()
 		{
-			if (edge_ == forest_edge::leading)
-			{
-				node* prev(node_->leading().prev);
-				if (prev->trailing().next == node_) edge_ = forest_edge::trailing;
-				node_ = prev;
-			}
-			else // (edge_ == forest_edge::trailing)
-			{
-				node* prev(node_->trailing().prev);
-				if (prev == node_) edge_ = forest_edge::leading;
-				node_ = prev;
-			}
-
+			forest_impl::decrement_edge(node_, edge_);
 			return *this;
 		}
 
@@ -249,17 +353,17 @@ namespace forest_impl {
 	template<typename Iter>
 	struct set_next_functor;
 
-	template<typename T>
-	struct set_next_functor<forest_iterator<T>> {
-		void operator()(forest_iterator<T> prev, forest_iterator<T> next) {
+	template<typename T, forest_augmentation Augmentation>
+	struct set_next_functor<forest_iterator<T, Augmentation>> {
+		void operator()(forest_iterator<T, Augmentation> prev, forest_iterator<T, Augmentation> next) {
 			prev.node_->get(prev.edge_).next = next.node_;
 			next.node_->get(next.edge_).prev = prev.node_;
 		}
 	};
 
-	template<typename T>
-	struct set_next_functor<forest_const_iterator<T>> {
-		void operator()(forest_const_iterator<T> prev, forest_const_iterator<T> next) {
+	template<typename T, forest_augmentation Augmentation>
+	struct set_next_functor<forest_const_iterator<T, Augmentation>> {
+		void operator()(forest_const_iterator<T, Augmentation> prev, forest_const_iterator<T, Augmentation> next) {
 			prev.node_->get(prev.edge_).next = next.node_;
 			next.node_->get(next.edge_).prev = prev.node_;
 		}
@@ -518,10 +622,169 @@ private:
 };
 
 
-template<typename T>
+/*
+	Full-order iterator which tracks depth of the current node relative to the starting one.
+	Depth grows when iterator moves between two leading edges and decreases between two trailing edges.
+*/
+template <typename Iter>
+class depth_fullorder_iterator
+{
+public:
+	using value_type = typename Iter::value_type;
+	using difference_type = typename Iter::difference_type;
+	using pointer = typename Iter::pointer;
+	using reference = typename Iter::reference;
+	using iterator_category = typename Iter::iterator_category;
+
+	depth_fullorder_iterator() : it_{}, depth_{ 0 } {}
+	explicit depth_fullorder_iterator(Iter it, difference_type depth = 0) : it_{ it }, depth_{ depth } {}
+
+	template <typename U>
+	explicit depth_fullorder_iterator(const depth_fullorder_iterator<U>& other) : it_{ other.base() }, depth_{ other.depth() } {}
+
+	difference_type depth() const { return depth_; }
+	Iter base() const { return it_; }
+
+	forest_edge edge() const { return it_.edge(); }
+	bool is_leading() const { return it_.is_leading(); }
+	bool is_trailing() const { return it_.is_trailing(); }
+
+	// Both edges of the node have the same depth
+	void make_leading() { it_.make_leading(); }
+	void make_trailing() { it_.make_trailing(); }
+
+	bool equal_node(const depth_fullorder_iterator& other) const { return it_.equal_node(other.it_); }
+
+	reference operator*() const { return *it_; }
+	pointer operator->() const { return &(*it_); }
+
+	depth_fullorder_iterator& operator++()
+	{
+		const forest_edge old = it_.edge();
+		++it_;
+		if (old == it_.edge()) depth_ += (old == forest_edge::leading) ? 1 : -1;
+		return *this;
+	}
+
+	depth_fullorder_iterator& operator--()
+	{
+		const forest_edge old = it_.edge();
+		--it_;
+		if (old == it_.edge()) depth_ += (old == forest_edge::leading) ? -1 : 1;
+		return *this;
+	}
+
+	depth_fullorder_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+	depth_fullorder_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+	friend bool operator==(const depth_fullorder_iterator& lhs, const depth_fullorder_iterator& rhs)
+	{
+		return lhs.it_ == rhs.it_;
+	}
+
+	friend bool operator!=(const depth_fullorder_iterator& lhs, const depth_fullorder_iterator& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+private:
+	Iter it_;
+	difference_type depth_;
+};
+
+
+/*
+	Preorder iterator which doesn't descend below max depth:
+	subtrees of the nodes at max depth are skipped by jumping to their trailing edges.
+*/
+template <typename Iter>
+class depth_limited_preorder_iterator
+{
+public:
+	using value_type = typename Iter::value_type;
+	using difference_type = typename Iter::difference_type;
+	using pointer = typename Iter::pointer;
+	using reference = typename Iter::reference;
+	using iterator_category = std::forward_iterator_tag;
+
+	depth_limited_preorder_iterator() : it_{}, maxDepth_{ 0 } {}
+	explicit depth_limited_preorder_iterator(Iter it, difference_type maxDepth)
+		: it_{ find_edge(depth_fullorder_iterator<Iter>(it), forest_edge::leading) }
+		, maxDepth_{ maxDepth }
+	{}
+
+	difference_type depth() const { return it_.depth(); }
+	Iter base() const { return it_.base(); }
+
+	reference operator*() const { return *it_; }
+	pointer operator->() const { return &(*it_); }
+
+	depth_limited_preorder_iterator& operator++()
+	{
+		do
+		{
+			if (it_.is_leading() && it_.depth() >= maxDepth_) it_.make_trailing();
+			++it_;
+		} while (!it_.is_leading());
+
+		return *this;
+	}
+
+	depth_limited_preorder_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+
+	friend bool operator==(const depth_limited_preorder_iterator& lhs, const depth_limited_preorder_iterator& rhs)
+	{
+		return lhs.it_ == rhs.it_;
+	}
+
+	friend bool operator!=(const depth_limited_preorder_iterator& lhs, const depth_limited_preorder_iterator& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+private:
+	depth_fullorder_iterator<Iter> it_;
+	difference_type maxDepth_;
+};
+
+
+namespace forest_impl {
+
+	template<typename Iter>
+	class iterator_range
+	{
+	public:
+		explicit iterator_range(Iter first, Iter last) : first_{ first }, last_{ last } {}
+
+		Iter begin() const { return first_; }
+		Iter end() const { return last_; }
+
+	private:
+		Iter first_;
+		Iter last_;
+	};
+
+}
+
+// Nodes of full-order range [first, last) in preorder down to maxDepth (nodes at first have depth 0)
+template <typename Iter>
+forest_impl::iterator_range<depth_limited_preorder_iterator<Iter>> depth_limited_preorder_range(Iter first, Iter last, typename Iter::difference_type maxDepth)
+{
+	using iterator = depth_limited_preorder_iterator<Iter>;
+	return forest_impl::iterator_range<iterator>(iterator(first, maxDepth), iterator(last, maxDepth));
+}
+
+
+/*
+	With forest_augmentation::subtree_sizes every node also keeps its parent and the size of its subtree.
+	They are maintained by emplace, erase and splice in O(depth) (erase of a single node also
+	reparents its children), so splice needs no counting and subtree_size is O(1).
+*/
+template<typename T, forest_augmentation Augmentation>
 class forest
 {	
-	using node = forest_impl::forest_node<T>;
+	using node = forest_impl::forest_node<T, Augmentation>;
+	static constexpr bool tracks_subtree_sizes = Augmentation == forest_augmentation::subtree_sizes;
 public:
 	using value_type = T;
 	using pointer = T*;
@@ -531,8 +794,8 @@ public:
 	using size_type = std::size_t;
 	using difference_type = std::ptrdiff_t;
 
-	using iterator = forest_impl::forest_iterator<T>;
-	using const_iterator = forest_impl::forest_const_iterator<T>;
+	using iterator = forest_impl::forest_iterator<T, Augmentation>;
+	using const_iterator = forest_impl::forest_const_iterator<T, Augmentation>;
 
 	using const_child_iterator = child_iterator<const_iterator>;
 	using child_iterator = child_iterator<iterator>;
@@ -546,46 +809,133 @@ public:
 	using postorder_iterator = edge_iterator<iterator, forest_edge::trailing>;
 	using const_postorder_iterator = edge_iterator<const_iterator, forest_edge::trailing>;
 
+	using depth_iterator = depth_fullorder_iterator<iterator>;
+	using const_depth_iterator = depth_fullorder_iterator<const_iterator>;
+
 	
-	forest() : size_{0}, tail_() {}
+	forest() : size_{0}, tail_(), pools_() {}
 	~forest() { clear(); }
+
+	// Clones the structure in one full-order walk into storage reserved for all nodes
 	forest(const forest& other) : forest()
 	{
-		insert(end(), child_iterator(other.begin()), child_iterator(other.end()));
+		if (other.empty()) return;
+
+		pool& storage = own_pool();
+		storage.reserve(other.size_);
+
+		std::vector<node*> parents;
+		iterator prev = root();
+		try
+		{
+			for (const_iterator first = other.begin(), last = other.end(); first != last; ++first)
+			{
+				iterator current;
+				if (first.is_leading())
+				{
+					current = iterator(make_node(first.node_->value), forest_edge::leading);
+					if constexpr (tracks_subtree_sizes)
+					{
+						current.node_->parent = parents.empty() ? nullptr : parents.back();
+						current.node_->subtree_size = first.node_->subtree_size;
+					}
+					parents.emplace_back(current.node_);
+				}
+				else
+				{
+					current = iterator(parents.back(), forest_edge::trailing);
+					parents.pop_back();
+				}
+
+				forest_impl::set_next(prev, current);
+				prev = current;
+			}
+		}
+		catch (...)
+		{
+			// Close the nodes that are already linked so that clear() can walk them
+			for (; !parents.empty(); parents.pop_back())
+			{
+				const iterator current(parents.back(), forest_edge::trailing);
+				forest_impl::set_next(prev, current);
+				prev = current;
+			}
+
+			forest_impl::set_next(prev, end());
+			clear();
+			throw;
+		}
+
+		forest_impl::set_next(prev, end());
+		size_ = other.size_;
 	}
 	forest& operator=(const forest& other)
 	{
-		auto tmp = other;
-		tmp.swap(other);
+		if (this != &other)
+		{
+			forest tmp(other);
+			swap(tmp);
+		}
+
 		return *this;
 	}
 
-	forest(forest&& other) noexcept : forest() { splice(end(), other); }
+	forest(forest&& other) noexcept : forest() { swap(other); }
 	forest& operator=(forest&& other) noexcept
 	{
-		clear();
-		splice(end(), other);
+		forest tmp(std::move(other));
+		swap(tmp);
 		return *this;
 	}
 
-	void swap(forest& other) noexcept { std::swap(*this, other); }
-
-	size_type size() const
+	// Exchanges contents in O(1), only the nodes adjacent to the tails are relinked
+	void swap(forest& other) noexcept
 	{
-		if (!size_valid()) 
-		{
-			const_preorder_iterator first(begin());
-			const_preorder_iterator last(end());
+		node* first = tail_.leading().next;
+		node* last = tail_.trailing().prev;
+		node* otherFirst = other.tail_.leading().next;
+		node* otherLast = other.tail_.trailing().prev;
 
-			size_ = size_type(std::distance(first, last));
-		}
+		if (first == tail()) first = last = nullptr;
+		if (otherFirst == other.tail()) otherFirst = otherLast = nullptr;
 
-		return size_;
+		attach_roots(otherFirst, otherLast);
+		other.attach_roots(first, last);
+
+		std::swap(size_, other.size_);
+		pools_.swap(other.pools_);
 	}
+
+	size_type size() const { return size_; }
+	// Next count nodes are allocated from one chunk
+	void reserve(size_type count) { own_pool().reserve(count); }
 	size_type max_size() const { return std::numeric_limits<size_type>::max(); }
-	bool size_valid() const { return size_ != 0 || empty(); }
 	bool empty() const { return begin() == end(); }
-	void clear() { erase(begin(), end()); assert(empty()); }
+
+	static size_type subtree_size(const_iterator pos)
+	{
+		static_assert(tracks_subtree_sizes, "forest has to be augmented with subtree sizes");
+		return pos.node_->subtree_size;
+	}
+	// Destroys values without relinking and releases node storage in bulk
+	void clear()
+	{
+		destroy_nodes();
+		tail_.reset();
+		size_ = 0;
+
+		if (!pools_.empty() && pools_.front().use_count() == 1)
+		{
+			pools_.front()->release();
+			pools_.resize(1);
+		}
+		else
+		{
+			pools_.clear();
+		}
+
+		assert(empty());
+	}
 
 	template<typename... Args>
 	iterator emplace(const_iterator pos, Args&&... args)
@@ -595,7 +945,12 @@ public:
 		forest_impl::set_next(std::prev(pos), const_iterator(result));
 		forest_impl::set_next(const_iterator(std::next(result)), pos);
 
-		if (size_valid()) ++size_;
+		++size_;
+		if constexpr (tracks_subtree_sizes)
+		{
+			result.node_->parent = parent_at(pos);
+			add_to_ancestors(result.node_, 1);
+		}
 
 		return result;
 	}
@@ -604,34 +959,102 @@ public:
 		for (const_iterator first(f.base()), last(l.base()); first != last; ++first, ++pos)
 		{
 			if (first.is_leading())
-				pos = insert(pos, *first);
+				pos = emplace(pos, *first);
 		}
 
 		return pos;
 	}
 
+	// Erases nodes whose both edges lie in [first, last) in one pass:
+	// every maximal run of erased subtrees is unlinked once at its boundaries
+	// and its nodes are returned to the pool as their trailing edges are passed.
 	iterator erase(const_iterator first, const_iterator last)
 	{
-		difference_type depth{ 0 };
-		while (first != last)
+		struct opened_node
 		{
-			if (first.is_leading())
+			node* n;
+			size_type erasedBelow;
+		};
+
+		if (first == cbegin() && last == cend())
+		{
+			clear();
+			return end();
+		}
+
+		const iterator end(last);
+		std::vector<opened_node> opened;
+		iterator runPrev = std::prev(iterator(first));
+		size_type pending = 0;
+
+		for (iterator pos(first); pos != end;)
+		{
+			node* current = pos.node_;
+			if (pos.is_leading())
 			{
-				++depth;
-				++first;
+				opened.push_back({ current, 0 });
+				++pos;
+				continue;
 			}
-			else
+
+			if (opened.empty())
 			{
-				if (depth > 0)
-					first = erase(first);
-				else
-					++first;
+				// Trailing edge of a node opened before the range: erased run ends here
+				forest_impl::set_next(runPrev, pos);
+				if constexpr (tracks_subtree_sizes)
+				{
+					if (pending > 0) subtract_subtree_size(current, pending);
+				}
+				pending = 0;
+				runPrev = pos;
+				++pos;
+				continue;
+			}
 
-				depth = std::max<difference_type>(0, depth - 1);
+			assert(opened.back().n == current);
+			opened.pop_back();
+			if constexpr (tracks_subtree_sizes)
+			{
+				if (opened.empty()) pending += current->subtree_size;
+				else opened.back().erasedBelow += current->subtree_size;
 			}
+
+			++pos;
+			delete_node(current);
+			--size_;
 		}
 
-		return last;
+		// Nodes still opened keep their leading edges and lose erased children
+		for (const auto& kept : opened)
+		{
+			const iterator leading(kept.n, forest_edge::leading);
+			forest_impl::set_next(runPrev, leading);
+			runPrev = leading;
+		}
+		forest_impl::set_next(runPrev, end);
+
+		if constexpr (tracks_subtree_sizes)
+		{
+			size_type erased = 0;
+			for (auto it = std::rbegin(opened); it != std::rend(opened); ++it)
+			{
+				erased += it->erasedBelow;
+				it->n->subtree_size -= erased;
+			}
+
+			if (!opened.empty())
+			{
+				add_to_ancestors(opened.front().n, size_type(0) - (erased + pending));
+			}
+			else if (pending > 0)
+			{
+				// Erased run is followed by its parent's trailing edge or by its next sibling
+				if (end.is_leading()) add_to_ancestors(end.node_, size_type(0) - pending);
+				else if (end.node_ != tail()) subtract_subtree_size(end.node_, pending);
+			}
+		}
+
+		return end;
 	}
 	iterator erase(const_iterator pos)
 	{
@@ -643,10 +1066,17 @@ public:
 		auto trailing_prev = std::prev(trailing);
 		auto trailing_next = std::next(trailing);
 
+		if constexpr (tracks_subtree_sizes)
+		{
+			add_to_ancestors(pos.node_, size_type(-1));
+			for (auto first = child_begin(pos), last = child_end(pos); first != last; ++first)
+				first.base().node_->parent = pos.node_->parent;
+		}
+
 		if (has_children(pos))
 		{
 			forest_impl::set_next(leading_prev, leading_next);
-			forest_impl::set_next(trailing_prev, trailing_prev);
+			forest_impl::set_next(trailing_prev, trailing_next);
 		}
 		else
 		{
@@ -654,7 +1084,7 @@ public:
 		}
 
 		delete_node(pos.node_);
-		if (size_valid()) --size_;
+		--size_;
 
 		return pos.is_leading() ? std::next(leading_prev) : trailing_next;
 	}
@@ -666,43 +1096,52 @@ public:
 			other, 
 			child_iterator(other.begin()), 
 			child_iterator(other.end()), 
-			other.size_valid() ? other.size() : 0);
+			other.size());
 	}
 	iterator splice(const_iterator position, forest& other, const_iterator it)
 	{
-		it.make_leading();
+		const iterator subtree(leading_of(it));
 		return splice(
 			position, 
 			other, 
-			child_iterator(it), 
-			++child_iterator(it), 
-			has_children(it) ? 0 : 1);
+			child_iterator(subtree), 
+			++child_iterator(subtree), 
+			has_children(subtree) ? 0 : 1);
 	}
+	// Zero count means the number of spliced nodes is unknown, it is then taken
+	// from subtree sizes of the roots if they are tracked or counted otherwise.
 	iterator splice(iterator pos, forest& other, child_iterator first, child_iterator last, size_type count)
 	{
 		if (first == last || first.base() == pos) return pos;
 
-		if (&other != this)
+		const bool moved = &other != this;
+		if (count == 0 && (moved || tracks_subtree_sizes))
+			count = other.count_nodes(first, last);
+
+		if constexpr (tracks_subtree_sizes)
 		{
-			if (count) 
-			{
-				if (size_valid())
-					size_ += count;
+			other.add_to_ancestors(first.base().node_, size_type(0) - count);
 
-				if (other.size_valid())
-					other.size_ -= count;
-			}
-			else 
-			{
-				size_ = 0;
-				other.size_ = 0;
-			}
+			node* parent = parent_at(pos);
+			for (child_iterator it = first; it != last; ++it)
+				it.base().node_->parent = parent;
+		}
+
+		if (moved)
+		{
+			adopt_pools(other);
+			size_ += count;
+			other.size_ -= count;
 		}
 
 		iterator back(std::prev(last.base()));
 		forest_impl::set_next(std::prev(first), last);
 		forest_impl::set_next(std::prev(pos), first.base());
 		forest_impl::set_next(back, pos);
+
+		if constexpr (tracks_subtree_sizes)
+			add_to_ancestors(first.base().node_, count);
+
 		return first.base();
 	}
 	iterator splice(iterator pos, forest& other, child_iterator first, child_iterator last)
@@ -712,7 +1151,7 @@ public:
 	
 	iterator insert_parent(child_iterator first, child_iterator last, const T& x) 
 	{
-		iterator result(insert(last.base(), x));
+		iterator result(emplace(last.base(), x));
 		if (first == last) return result;
 
 		splice(trailing_of(result), *this, first, child_iterator(result));
@@ -749,20 +1188,126 @@ public:
 	const_reverse_iterator rend() const { return crend(); }
 
 private:
+	using pool = forest_impl::node_pool<node>;
+
 	template<typename... Args>
-	node* make_node(Args&&... args) { return new node(std::forward<Args>(args)...); }
-	void delete_node(node* n) { delete n; }
+	node* make_node(Args&&... args)
+	{
+		pool& storage = own_pool();
+		void* memory = storage.allocate();
+		try
+		{
+			return new (memory) node(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			storage.deallocate(memory);
+			throw;
+		}
+	}
+
+	void delete_node(node* n)
+	{
+		n->~node();
+		pools_.front()->deallocate(n);
+	}
+
+	// Parent of the node inserted before pos: node of the trailing edge or parent of the next sibling
+	node* parent_at(const_iterator pos) const
+	{
+		if (pos.is_leading()) return pos.node_->parent;
+		return pos.node_ == tail() ? nullptr : pos.node_;
+	}
+
+	void add_to_ancestors(node* n, size_type delta)
+	{
+		for (node* p = n->parent; p != nullptr; p = p->parent)
+			p->subtree_size += delta;
+	}
+
+	void subtract_subtree_size(node* n, size_type count)
+	{
+		n->subtree_size -= count;
+		add_to_ancestors(n, size_type(0) - count);
+	}
+
+	size_type count_nodes(child_iterator first, child_iterator last) const
+	{
+		size_type result = 0;
+		if constexpr (tracks_subtree_sizes)
+		{
+			for (; first != last; ++first)
+				result += first.base().node_->subtree_size;
+		}
+		else
+		{
+			for (iterator it = first.base(), end = last.base(); it != end; ++it)
+				result += it.is_leading() ? 1 : 0;
+		}
+
+		return result;
+	}
+
+	void destroy_nodes()
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+		{
+			for (iterator first = begin(), last = end(); first != last;)
+			{
+				node* current = first.node_;
+				const bool trailing = first.is_trailing();
+				++first;
+				if (trailing) current->~node();
+			}
+		}
+	}
+
+	// Nodes spliced from other forest stay in its chunks, so the chunks have to outlive them
+	void adopt_pools(const forest& other)
+	{
+		own_pool();
+		for (const auto& p : other.pools_)
+		{
+			if (std::find(std::cbegin(pools_), std::cend(pools_), p) == std::cend(pools_))
+				pools_.emplace_back(p);
+		}
+	}
+
+	// Pool is created on first allocation, so empty and moved-from forests own no storage
+	pool& own_pool()
+	{
+		if (pools_.empty()) pools_.emplace_back(std::make_shared<pool>());
+		return *pools_.front();
+	}
+
+	// Links first and last root nodes to the tail, nullptr makes the forest empty
+	void attach_roots(node* first, node* last)
+	{
+		if (first == nullptr)
+		{
+			tail_.leading().next = tail();
+			tail_.trailing().prev = tail();
+			return;
+		}
+
+		tail_.leading().next = first;
+		first->leading().prev = tail();
+		tail_.trailing().prev = last;
+		last->trailing().next = tail();
+	}
 
 	node* tail() const { return static_cast<node*>(&tail_); }
 
 private:
 	size_type size_;
 	mutable forest_impl::forest_node_base<node> tail_;
+	// Front pool allocates new nodes, the rest keep alive storage of nodes spliced from other forests
+	std::vector<std::shared_ptr<pool>> pools_;
 };
 
 
-template <typename T>
-bool operator==(const forest<T>& lhs, const forest<T>& rhs) {
+template <typename T, forest_augmentation Augmentation>
+bool operator==(const forest<T, Augmentation>& lhs, const forest<T, Augmentation>& rhs) {
 	if (lhs.size() != rhs.size())
 		return false;
 
@@ -770,15 +1315,25 @@ bool operator==(const forest<T>& lhs, const forest<T>& rhs) {
 	{
 		if (first.edge() != pos.edge())
 			return false;
-		if (first.edge() && (*first != *pos))
+		if (first.is_leading() && (*first != *pos))
 			return false;
 	}
 
 	return true;
 }
 
-template <typename T>
-bool operator!=(const forest<T>& lhs, const forest<T>& rhs) { return !(lhs == rhs); }
+template <typename T, forest_augmentation Augmentation>
+bool operator!=(const forest<T, Augmentation>& lhs, const forest<T, Augmentation>& rhs) { return !(lhs == rhs); }
+
+template <typename T, forest_augmentation Augmentation>
+void swap(forest<T, Augmentation>& lhs, forest<T, Augmentation>& rhs) noexcept { lhs.swap(rhs); }
+
+
+template <typename T, forest_augmentation Augmentation>
+auto depth_limited_preorder_range(forest<T, Augmentation>& f, std::ptrdiff_t maxDepth) { return depth_limited_preorder_range(f.begin(), f.end(), maxDepth); }
+
+template <typename T, forest_augmentation Augmentation>
+auto depth_limited_preorder_range(const forest<T, Augmentation>& f, std::ptrdiff_t maxDepth) { return depth_limited_preorder_range(f.begin(), f.end(), maxDepth); }
 
 
 template <typename Iter>
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "forest.hpp"
+#include "tree.hpp"
+#include "binary_tree.hpp"
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+
+/*
+	Conversions between forest, tree and binary_tree.
+	Target storage is reserved for all nodes up front and the source is walked once.
+	Overloads taking rvalue source move values out of it and clear it, the others copy them.
+	Cleared tree keeps its root (tree can't be empty) with moved-from value.
+
+	binary_tree holds forest in left-child/right-sibling form: left link points to the first child,
+	right link to the next sibling, roots of the forest are siblings of binary_tree root.
+	tree has exactly one root, so forest with other number of roots can't be converted to it.
+*/
+namespace forest_conversions_impl
+{
+
+	template<typename Source, typename Value>
+	decltype(auto) take(Value& value)
+	{
+		if constexpr (std::is_rvalue_reference_v<Source&&>) return std::move(value);
+		else return static_cast<const Value&>(value);
+	}
+
+	template<typename Index, binary_tree_augmentation Augmentation, typename Forest>
+	auto to_binary_tree(Forest&& f)
+	{
+		using value_type = typename std::decay_t<Forest>::value_type;
+		using node = typename binary_tree<value_type, Index, Augmentation>::node;
+
+		binary_tree<value_type, Index, Augmentation> result(empty_binary_tree);
+		result.reserve(f.size());
+
+		// Every opened node with its last child emplaced so far
+		std::vector<std::pair<node, node>> opened;
+		node lastRoot = node::null_node();
+		for (auto first = f.begin(), last = f.end(); first != last; ++first)
+		{
+			if (first.is_trailing())
+			{
+				opened.pop_back();
+				continue;
+			}
+
+			auto&& value = take<Forest>(*first);
+			node current = node::null_node();
+			if (opened.empty())
+			{
+				current = lastRoot.is_null() ? result.emplace_root(std::forward<decltype(value)>(value)) : result.emplace_right(lastRoot, std::forward<decltype(value)>(value));
+				lastRoot = current;
+			}
+			else
+			{
+				auto& [parent, lastChild] = opened.back();
+				current = lastChild.is_null() ? result.emplace_left(parent, std::forward<decltype(value)>(value)) : result.emplace_right(lastChild, std::forward<decltype(value)>(value));
+				lastChild = current;
+			}
+
+			opened.emplace_back(current, node::null_node());
+		}
+
+		return result;
+	}
+
+	template<typename BinaryTree>
+	auto from_binary_tree(BinaryTree&& tr)
+	{
+		using tree_type = std::decay_t<BinaryTree>;
+		using node = typename tree_type::node;
+		using forest_type = forest<typename tree_type::value_type>;
+
+		forest_type result;
+		result.reserve(tr.size());
+
+		// Sibling chains to emplace before the trailing edge of their parent
+		std::vector<std::pair<node, typename forest_type::iterator>> chains;
+		if (!tr.root().is_null()) chains.emplace_back(tr.root(), result.end());
+
+		while (!chains.empty())
+		{
+			const auto [first, pos] = chains.back();
+			chains.pop_back();
+
+			for (node current = first; !current.is_null(); current = tr.right(current))
+			{
+				const auto inserted = result.emplace(pos, take<BinaryTree>(tr.value(current)));
+				if (const node child = tr.left(current); !child.is_null())
+					chains.emplace_back(child, trailing_of(inserted));
+			}
+		}
+
+		return result;
+	}
+
+	template<typename Index, typename Forest>
+	auto to_tree(Forest&& f)
+	{
+		using value_type = typename std::decay_t<Forest>::value_type;
+		using node = typename tree<value_type, Index>::node;
+
+		auto first = f.begin();
+		const auto last = f.end();
+		if (first == last || std::next(trailing_of(first)) != last)
+			throw std::invalid_argument("forest must contain exactly one tree");
+
+		tree<value_type, Index> result(take<Forest>(*first));
+		result.reserve(f.size());
+
+		std::vector<node> opened{ result.root() };
+		for (++first; first != trailing_of(f.begin()); ++first)
+		{
+			if (first.is_trailing())
+				opened.pop_back();
+			else
+				opened.emplace_back(result.emplace_child(opened.back(), take<Forest>(*first)));
+		}
+
+		return result;
+	}
+
+	template<typename Tree>
+	auto from_tree(Tree&& tr)
+	{
+		using tree_type = std::decay_t<Tree>;
+		using node = typename tree_type::node;
+		using forest_type = forest<std::decay_t<decltype(tr.value_of(tr.root()))>>;
+
+		forest_type result;
+		result.reserve(tr.size());
+
+		std::vector<std::pair<node, typename forest_type::iterator>> pending{ { tr.root(), result.end() } };
+		while (!pending.empty())
+		{
+			const auto [current, pos] = pending.back();
+			pending.pop_back();
+
+			const auto inserted = result.emplace(pos, take<Tree>(tr.value_of(current)));
+			// Children are pushed in reverse to be emplaced in their order
+			for (auto it = tr.cend(current); it != tr.cbegin(current);)
+				pending.emplace_back(*--it, trailing_of(inserted));
+		}
+
+		return result;
+	}
+
+}
+
+
+template<typename Index = std::size_t, binary_tree_augmentation TreeAugmentation = binary_tree_augmentation::none, typename T, forest_augmentation Augmentation>
+binary_tree<T, Index, TreeAugmentation> forest_to_binary_tree(const forest<T, Augmentation>& f)
+{
+	return forest_conversions_impl::to_binary_tree<Index, TreeAugmentation>(f);
+}
+
+template<typename Index = std::size_t, binary_tree_augmentation TreeAugmentation = binary_tree_augmentation::none, typename T, forest_augmentation Augmentation>
+binary_tree<T, Index, TreeAugmentation> forest_to_binary_tree(forest<T, Augmentation>&& f)
+{
+	auto result = forest_conversions_impl::to_binary_tree<Index, TreeAugmentation>(std::move(f));
+	f.clear();
+	return result;
+}
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+forest<T> binary_tree_to_forest(const binary_tree<T, Index, Augmentation>& tr) { return forest_conversions_impl::from_binary_tree(tr); }
+
+template<typename T, typename Index, binary_tree_augmentation Augmentation>
+forest<T> binary_tree_to_forest(binary_tree<T, Index, Augmentation>&& tr)
+{
+	auto result = forest_conversions_impl::from_binary_tree(std::move(tr));
+	tr.clear();
+	return result;
+}
+
+template<typename Index = std::size_t, typename T, forest_augmentation Augmentation>
+tree<T, Index> forest_to_tree(const forest<T, Augmentation>& f) { return forest_conversions_impl::to_tree<Index>(f); }
+
+template<typename Index = std::size_t, typename T, forest_augmentation Augmentation>
+tree<T, Index> forest_to_tree(forest<T, Augmentation>&& f)
+{
+	auto result = forest_conversions_impl::to_tree<Index>(std::move(f));
+	f.clear();
+	return result;
+}
+
+template<typename T, typename Index>
+forest<T> tree_to_forest(const tree<T, Index>& tr) { return forest_conversions_impl::from_tree(tr); }
+
+template<typename T, typename Index>
+forest<T> tree_to_forest(tree<T, Index>&& tr)
+{
+	auto result = forest_conversions_impl::from_tree(std::move(tr));
+	tr.clear();
+	return result;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "forest.hpp"
+#include "task_budget.hpp"
+
+#include <vector>
+#include <future>
+#include <algorithm>
+
+
+namespace forest_impl
+{
+
+	// Subtree sizes are known without walking only for forests augmented with them
+	template<typename Iter>
+	struct tracked_subtree_size { static constexpr bool value = false; };
+
+	template<typename T>
+	struct tracked_subtree_size<forest_iterator<T, forest_augmentation::subtree_sizes>>
+	{
+		static constexpr bool value = true;
+		static std::size_t of(forest_const_iterator<T, forest_augmentation::subtree_sizes> it) { return forest<T, forest_augmentation::subtree_sizes>::subtree_size(it); }
+	};
+
+	template<typename T>
+	struct tracked_subtree_size<forest_const_iterator<T, forest_augmentation::subtree_sizes>>
+		: tracked_subtree_size<forest_iterator<T, forest_augmentation::subtree_sizes>> {};
+
+	template<typename Iter, typename Func>
+	struct subtree_visit
+	{
+		Func& func;
+		task_budget& budget;
+		std::size_t minSplitSize;
+	};
+
+	template<typename Iter, typename Func>
+	void fork_subtrees(const std::vector<Iter>& roots, subtree_visit<Iter, Func>& visit, std::size_t splitDepth);
+
+	template<typename Iter>
+	std::vector<Iter> collect_children(const Iter& leading)
+	{
+		std::vector<Iter> result;
+		for (auto first = child_begin(leading), last = child_end(leading); first != last; ++first)
+			result.emplace_back(first.base());
+
+		return result;
+	}
+
+	// Walks at most limit nodes of the subtree, so the cost doesn't depend on the subtree size
+	template<typename Iter>
+	bool subtree_reaches(Iter leading, std::size_t limit)
+	{
+		std::size_t count = 0;
+		for (auto first = leading, last = trailing_of(leading); count < limit; ++first)
+		{
+			if (first.is_leading()) ++count;
+			if (first == last) break;
+		}
+
+		return count >= limit;
+	}
+
+	// Subtree is split when its size reaches minSplitSize, without tracked sizes
+	// its nodes are counted until minSplitSize is reached
+	template<typename Iter, typename Func>
+	void visit_subtree(Iter leading, subtree_visit<Iter, Func>& visit, std::size_t splitDepth)
+	{
+		if (splitDepth > 0 && has_children(leading))
+		{
+			bool large = false;
+			if constexpr (tracked_subtree_size<Iter>::value) large = tracked_subtree_size<Iter>::of(leading) >= visit.minSplitSize;
+			else large = subtree_reaches(leading, visit.minSplitSize);
+
+			if (large)
+			{
+				visit.func(leading, leading);
+				fork_subtrees(collect_children(leading), visit, splitDepth - 1);
+				return;
+			}
+		}
+
+		visit.func(leading, trailing_of(leading));
+	}
+
+	// Siblings are divided into contiguous groups, one per task taken from the budget
+	template<typename Iter, typename Func>
+	void fork_subtrees(const std::vector<Iter>& roots, subtree_visit<Iter, Func>& visit, std::size_t splitDepth)
+	{
+		if (roots.empty()) return;
+
+		const std::size_t forked = visit.budget.acquire(std::size(roots) - 1);
+		const std::size_t groups = forked + 1;
+
+		std::vector<std::future<void>> tasks;
+		tasks.reserve(forked);
+		for (std::size_t group = 1; group < groups; ++group)
+		{
+			tasks.emplace_back(std::async(std::launch::async, [&roots, &visit, splitDepth, group, groups] {
+				task_budget_slot slot(visit.budget);
+				const std::size_t begin = std::size(roots) * group / groups;
+				const std::size_t end = std::size(roots) * (group + 1) / groups;
+				for (std::size_t i = begin; i < end; ++i)
+					visit_subtree(roots[i], visit, splitDepth);
+			}));
+		}
+
+		for (std::size_t i = 0, end = std::size(roots) / groups; i < end; ++i)
+			visit_subtree(roots[i], visit, splitDepth);
+
+		for (auto& task : tasks)
+			task.get();
+	}
+
+}
+
+
+/*
+	Hands every sibling subtree in [first, last) to a worker as inclusive full-order range
+	[leading, trailing] of its root. With splitDepth > 0 large subtrees are split
+	recursively: their root is handed alone as [leading, leading] and child subtrees
+	are distributed among workers the same way, splitDepth levels down.
+	A subtree is large when it has at least minSplitSize nodes; for forests without
+	forest_augmentation::subtree_sizes up to minSplitSize of its nodes are counted.
+	At most one task per hardware thread runs at any time during the whole traversal.
+	func is called concurrently for disjoint subtrees and must be thread safe,
+	order of calls is unspecified.
+*/
+template<typename Iter, typename Func>
+void parallel_for_each_subtree(child_iterator<Iter> first, child_iterator<Iter> last, Func func, std::size_t splitDepth = 0, std::size_t minSplitSize = 1024)
+{
+	std::vector<Iter> roots;
+	for (; first != last; ++first)
+		roots.emplace_back(first.base());
+
+	task_budget budget(task_budget::hardware_tasks());
+	forest_impl::subtree_visit<Iter, Func> visit{ func, budget, minSplitSize };
+	forest_impl::fork_subtrees(roots, visit, splitDepth);
+}
@@ -0,0 +1,379 @@
+#pragma once
+
+#include "forest.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+/*
+	Compact binary encoding of forest<T>.
+
+	Stream starts with node count (64-bit little-endian) followed by blocks of up to 64 edges
+	in full order. Every block is a 64-bit little-endian mask with one bit per edge
+	(set for leading edge) followed by values of the nodes whose leading edges are in the block.
+	Values are written by forest_value_codec<T>, which may be specialized for user types.
+	Arithmetic and enum values, string lengths and characters are stored little-endian.
+	Other trivially copyable types are stored in their native object representation,
+	so such data can't be read on a platform with different byte order or layout.
+
+	Writers provide write(const void*, size_t), readers provide read(void*, size_t).
+*/
+namespace forest_serialization_impl
+{
+
+	constexpr std::size_t block_edges = 64;
+
+	template<typename Writer>
+	void write_uint64(Writer& out, std::uint64_t value)
+	{
+		unsigned char bytes[8];
+		for (std::size_t i = 0; i < 8; ++i)
+			bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+
+		out.write(bytes, sizeof(bytes));
+	}
+
+	template<typename Reader>
+	std::uint64_t read_uint64(Reader& in)
+	{
+		unsigned char bytes[8];
+		in.read(bytes, sizeof(bytes));
+
+		std::uint64_t result = 0;
+		for (std::size_t i = 0; i < 8; ++i)
+			result |= std::uint64_t(bytes[i]) << (8 * i);
+
+		return result;
+	}
+
+	inline bool little_endian_host()
+	{
+		const std::uint16_t one = 1;
+		unsigned char first = 0;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	// Converts between native and little-endian byte order of count values, in either direction
+	template<typename T>
+	void swap_to_little_endian(T* values, std::size_t count)
+	{
+		if constexpr (sizeof(T) > 1)
+		{
+			if (little_endian_host()) return;
+
+			auto bytes = reinterpret_cast<unsigned char*>(values);
+			for (std::size_t i = 0; i < count; ++i, bytes += sizeof(T))
+				std::reverse(bytes, bytes + sizeof(T));
+		}
+	}
+
+}
+
+
+// Values are stored as their object representation by default, arithmetic and enum values little-endian
+template<typename T>
+struct forest_value_codec
+{
+	static_assert(std::is_trivially_copyable_v<T>, "forest_value_codec has to be specialized for this type");
+
+	static constexpr bool portable = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+	template<typename Writer>
+	static void write(Writer& out, T value)
+	{
+		if constexpr (portable) forest_serialization_impl::swap_to_little_endian(&value, 1);
+		out.write(&value, sizeof(T));
+	}
+
+	template<typename Reader>
+	static T read(Reader& in)
+	{
+		T result;
+		in.read(&result, sizeof(T));
+		if constexpr (portable) forest_serialization_impl::swap_to_little_endian(&result, 1);
+		return result;
+	}
+};
+
+template<typename Char, typename Traits, typename Allocator>
+struct forest_value_codec<std::basic_string<Char, Traits, Allocator>>
+{
+	using string_type = std::basic_string<Char, Traits, Allocator>;
+
+	// Length comes from untrusted input, so storage grows with the data actually read
+	static constexpr std::size_t chunk_size = (1 << 16) / sizeof(Char);
+
+	template<typename Writer>
+	static void write(Writer& out, const string_type& value)
+	{
+		forest_serialization_impl::write_uint64(out, std::size(value));
+		if (sizeof(Char) == 1 || forest_serialization_impl::little_endian_host())
+		{
+			out.write(std::data(value), std::size(value) * sizeof(Char));
+			return;
+		}
+
+		Char chunk[256];
+		for (std::size_t done = 0; done < std::size(value);)
+		{
+			const std::size_t count = std::min(std::size(value) - done, std::size(chunk));
+			std::copy_n(std::data(value) + done, count, chunk);
+			forest_serialization_impl::swap_to_little_endian(chunk, count);
+			out.write(chunk, count * sizeof(Char));
+			done += count;
+		}
+	}
+
+	template<typename Reader>
+	static string_type read(Reader& in)
+	{
+		const std::uint64_t length = forest_serialization_impl::read_uint64(in);
+
+		string_type result;
+		if (length > result.max_size()) throw std::runtime_error("invalid forest data");
+
+		for (std::size_t done = 0; done < length;)
+		{
+			const std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(length - done, chunk_size));
+			result.resize(done + count);
+			in.read(std::data(result) + done, count * sizeof(Char));
+			forest_serialization_impl::swap_to_little_endian(std::data(result) + done, count);
+			done += count;
+		}
+
+		return result;
+	}
+};
+
+
+class memory_writer
+{
+public:
+	explicit memory_writer(std::vector<unsigned char>& buffer) : buffer_{ &buffer } {}
+
+	void write(const void* data, std::size_t size)
+	{
+		const auto bytes = static_cast<const unsigned char*>(data);
+		buffer_->insert(std::end(*buffer_), bytes, bytes + size);
+	}
+
+private:
+	std::vector<unsigned char>* buffer_;
+};
+
+class memory_reader
+{
+public:
+	explicit memory_reader(const void* data, std::size_t size)
+		: current_{ static_cast<const unsigned char*>(data) }
+		, end_{ current_ + size }
+	{}
+
+	explicit memory_reader(const std::vector<unsigned char>& buffer) : memory_reader(std::data(buffer), std::size(buffer)) {}
+
+	void read(void* data, std::size_t size)
+	{
+		if (static_cast<std::size_t>(end_ - current_) < size)
+			throw std::runtime_error("unexpected end of forest data");
+
+		std::memcpy(data, current_, size);
+		current_ += size;
+	}
+
+private:
+	const unsigned char* current_;
+	const unsigned char* end_;
+};
+
+
+// Buffered writer to file descriptor, data is flushed on flush() and in destructor
+class fd_writer
+{
+	static constexpr std::size_t buffer_size = 1 << 16;
+
+public:
+	explicit fd_writer(int fd) : fd_{ fd } { buffer_.reserve(buffer_size); }
+	~fd_writer() { try { flush(); } catch (...) {} }
+
+	fd_writer(const fd_writer&) = delete;
+	fd_writer& operator=(const fd_writer&) = delete;
+
+	void write(const void* data, std::size_t size)
+	{
+		if (std::size(buffer_) + size > buffer_size)
+		{
+			flush();
+			if (size > buffer_size)
+			{
+				write_all(data, size);
+				return;
+			}
+		}
+
+		const auto bytes = static_cast<const unsigned char*>(data);
+		buffer_.insert(std::end(buffer_), bytes, bytes + size);
+	}
+
+	void flush()
+	{
+		write_all(std::data(buffer_), std::size(buffer_));
+		buffer_.clear();
+	}
+
+private:
+	void write_all(const void* data, std::size_t size)
+	{
+		auto bytes = static_cast<const unsigned char*>(data);
+		while (size > 0)
+		{
+#ifdef _WIN32
+			const auto written = ::_write(fd_, bytes, static_cast<unsigned int>(std::min<std::size_t>(size, buffer_size)));
+#else
+			const auto written = ::write(fd_, bytes, size);
+#endif
+			if (written <= 0) throw std::runtime_error("failed to write forest data");
+
+			bytes += written;
+			size -= static_cast<std::size_t>(written);
+		}
+	}
+
+private:
+	int fd_;
+	std::vector<unsigned char> buffer_;
+};
+
+// Buffered reader from file descriptor, may read ahead past the end of the forest data
+class fd_reader
+{
+	static constexpr std::size_t buffer_size = 1 << 16;
+
+public:
+	explicit fd_reader(int fd) : fd_{ fd }, buffer_(buffer_size), current_{ 0 }, end_{ 0 } {}
+
+	void read(void* data, std::size_t size)
+	{
+		auto bytes = static_cast<unsigned char*>(data);
+		while (size > 0)
+		{
+			if (current_ == end_) fill();
+
+			const std::size_t chunk = std::min(size, end_ - current_);
+			std::memcpy(bytes, std::data(buffer_) + current_, chunk);
+			current_ += chunk;
+			bytes += chunk;
+			size -= chunk;
+		}
+	}
+
+private:
+	void fill()
+	{
+#ifdef _WIN32
+		const auto received = ::_read(fd_, std::data(buffer_), static_cast<unsigned int>(buffer_size));
+#else
+		const auto received = ::read(fd_, std::data(buffer_), buffer_size);
+#endif
+		if (received <= 0) throw std::runtime_error("unexpected end of forest data");
+
+		current_ = 0;
+		end_ = static_cast<std::size_t>(received);
+	}
+
+private:
+	int fd_;
+	std::vector<unsigned char> buffer_;
+	std::size_t current_;
+	std::size_t end_;
+};
+
+
+template<typename T, forest_augmentation Augmentation, typename Writer>
+void encode_forest(const forest<T, Augmentation>& f, Writer& out)
+{
+	using forest_serialization_impl::block_edges;
+
+	forest_serialization_impl::write_uint64(out, f.size());
+
+	auto first = f.begin();
+	const auto last = f.end();
+	while (first != last)
+	{
+		std::uint64_t mask = 0;
+		auto blockFirst = first;
+		for (std::size_t i = 0; i < block_edges && first != last; ++i, ++first)
+		{
+			if (first.is_leading())
+				mask |= std::uint64_t(1) << i;
+		}
+
+		forest_serialization_impl::write_uint64(out, mask);
+		for (; blockFirst != first; ++blockFirst)
+		{
+			if (blockFirst.is_leading())
+				forest_value_codec<T>::write(out, *blockFirst);
+		}
+	}
+}
+
+// Appends decoded trees to the end of the forest, building them with emplace at the trailing edge of the current node
+template<typename T, forest_augmentation Augmentation, typename Reader>
+void decode_forest(Reader& in, forest<T, Augmentation>& result)
+{
+	using forest_serialization_impl::block_edges;
+
+	const std::uint64_t count = forest_serialization_impl::read_uint64(in);
+	if (count > std::numeric_limits<std::uint64_t>::max() / 2) throw std::runtime_error("invalid forest data");
+
+	auto pos = result.end();
+	std::uint64_t edges = 2 * count;
+	std::uint64_t opened = 0;
+	std::uint64_t depth = 0;
+	while (edges > 0)
+	{
+		const std::uint64_t mask = forest_serialization_impl::read_uint64(in);
+		const std::size_t blockSize = static_cast<std::size_t>(std::min<std::uint64_t>(edges, block_edges));
+		for (std::size_t i = 0; i < blockSize; ++i)
+		{
+			if (mask & (std::uint64_t(1) << i))
+			{
+				if (++opened > count) throw std::runtime_error("invalid forest data");
+
+				pos = trailing_of(result.emplace(pos, forest_value_codec<T>::read(in)));
+				++depth;
+			}
+			else
+			{
+				if (depth == 0) throw std::runtime_error("invalid forest data");
+
+				++pos;
+				--depth;
+			}
+		}
+
+		edges -= blockSize;
+	}
+}
+
+template<typename T, typename Reader>
+forest<T> decode_forest(Reader& in)
+{
+	forest<T> result;
+	decode_forest(in, result);
+	return result;
+}
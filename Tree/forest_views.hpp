@@ -0,0 +1,259 @@
+#pragma once
+
+#include "forest.hpp"
+
+#include <iterator>
+#include <functional>
+#include <type_traits>
+
+
+// What happens to the subtree of node rejected by filter
+enum class forest_filter
+{
+	prune_subtree,	// node is hidden together with its descendants
+	hide_children	// node is kept, its descendants are hidden
+};
+
+namespace forest_views_impl
+{
+
+	// Nodes of the range boundary (end and root) are never passed to the predicate
+	template<typename Iter, typename Pred>
+	bool accepted(const Iter& it, const Iter& last, const Pred& pred)
+	{
+		return it.equal_node(last) || std::invoke(pred, *it);
+	}
+
+}
+
+
+/*
+	Full-order iterator which skips nodes rejected by predicate without visiting their subtrees:
+	rejected node is jumped over from one of its edges to the other.
+	Predicate is owned by the view and is evaluated on every step, results aren't cached.
+	All edges it stops at belong to visible nodes, so edge and child adaptors work on top of it.
+*/
+template<typename Iter, typename Pred, forest_filter Filter>
+class filter_fullorder_iterator
+{
+public:
+	using value_type = typename Iter::value_type;
+	using difference_type = typename Iter::difference_type;
+	using pointer = typename Iter::pointer;
+	using reference = typename Iter::reference;
+	using iterator_category = typename Iter::iterator_category;
+
+	filter_fullorder_iterator() : it_{}, last_{}, pred_{ nullptr } {}
+	explicit filter_fullorder_iterator(Iter it, Iter last, const Pred* pred)
+		: it_{ it }, last_{ last }, pred_{ pred }
+	{
+		if constexpr (Filter == forest_filter::prune_subtree)
+			skip_forward();
+	}
+
+	Iter base() const { return it_; }
+
+	forest_edge edge() const { return it_.edge(); }
+	bool is_leading() const { return it_.is_leading(); }
+	bool is_trailing() const { return it_.is_trailing(); }
+
+	void make_leading() { it_.make_leading(); }
+	void make_trailing() { it_.make_trailing(); }
+
+	bool equal_node(const filter_fullorder_iterator& other) const { return it_.equal_node(other.it_); }
+
+	reference operator*() const { return *it_; }
+	pointer operator->() const { return &(*it_); }
+
+	filter_fullorder_iterator& operator++()
+	{
+		if constexpr (Filter == forest_filter::prune_subtree)
+		{
+			++it_;
+			skip_forward();
+		}
+		else
+		{
+			if (it_.is_leading() && !accepted()) it_.make_trailing();
+			else ++it_;
+		}
+
+		return *this;
+	}
+
+	filter_fullorder_iterator& operator--()
+	{
+		if constexpr (Filter == forest_filter::prune_subtree)
+		{
+			--it_;
+			while (it_.is_trailing() && !accepted())
+			{
+				it_.make_leading();
+				--it_;
+			}
+		}
+		else
+		{
+			if (it_.is_trailing() && !accepted()) it_.make_leading();
+			else --it_;
+		}
+
+		return *this;
+	}
+
+	filter_fullorder_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+	filter_fullorder_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+	friend bool operator==(const filter_fullorder_iterator& lhs, const filter_fullorder_iterator& rhs)
+	{
+		return lhs.it_ == rhs.it_;
+	}
+
+	friend bool operator!=(const filter_fullorder_iterator& lhs, const filter_fullorder_iterator& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+private:
+	bool accepted() const { return forest_views_impl::accepted(it_, last_, *pred_); }
+
+	void skip_forward()
+	{
+		while (it_.is_leading() && !accepted())
+		{
+			it_.make_trailing();
+			++it_;
+		}
+	}
+
+private:
+	Iter it_;
+	Iter last_;
+	const Pred* pred_;
+};
+
+
+/*
+	Full-order iterator which dereferences to result of function applied to the value.
+	Function is owned by the view and is called on every dereference.
+*/
+template<typename Iter, typename Func>
+class transform_fullorder_iterator
+{
+public:
+	using reference = std::invoke_result_t<const Func&, typename Iter::reference>;
+	using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+	using difference_type = typename Iter::difference_type;
+	using pointer = std::conditional_t<std::is_lvalue_reference_v<reference>, std::add_pointer_t<reference>, void>;
+	using iterator_category = typename Iter::iterator_category;
+
+	transform_fullorder_iterator() : it_{}, func_{ nullptr } {}
+	explicit transform_fullorder_iterator(Iter it, const Func* func) : it_{ it }, func_{ func } {}
+
+	Iter base() const { return it_; }
+
+	forest_edge edge() const { return it_.edge(); }
+	bool is_leading() const { return it_.is_leading(); }
+	bool is_trailing() const { return it_.is_trailing(); }
+
+	void make_leading() { it_.make_leading(); }
+	void make_trailing() { it_.make_trailing(); }
+
+	bool equal_node(const transform_fullorder_iterator& other) const { return it_.equal_node(other.it_); }
+
+	reference operator*() const { return std::invoke(*func_, *it_); }
+	pointer operator->() const { return &(**this); }
+
+	transform_fullorder_iterator& operator++() { ++it_; return *this; }
+	transform_fullorder_iterator& operator--() { --it_; return *this; }
+
+	transform_fullorder_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+	transform_fullorder_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+	friend bool operator==(const transform_fullorder_iterator& lhs, const transform_fullorder_iterator& rhs)
+	{
+		return lhs.it_ == rhs.it_;
+	}
+
+	friend bool operator!=(const transform_fullorder_iterator& lhs, const transform_fullorder_iterator& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+private:
+	Iter it_;
+	const Func* func_;
+};
+
+
+/*
+	Lazy view of full-order range [first, last) of forest nodes accepted by predicate.
+	Nothing is copied: iterators walk the underlying forest and keep pointer to the predicate
+	stored in the view, so the view has to outlive them.
+*/
+template<typename Iter, typename Pred, forest_filter Filter = forest_filter::prune_subtree>
+class filtered_forest_view
+{
+public:
+	using iterator = filter_fullorder_iterator<Iter, Pred, Filter>;
+	using child_iterator = ::child_iterator<iterator>;
+	using preorder_iterator = edge_iterator<iterator, forest_edge::leading>;
+	using postorder_iterator = edge_iterator<iterator, forest_edge::trailing>;
+
+	explicit filtered_forest_view(Iter first, Iter last, Pred pred)
+		: first_{ first }, last_{ last }, pred_{ std::move(pred) } {}
+
+	iterator begin() const { return iterator(first_, last_, &pred_); }
+	iterator end() const { return iterator(last_, last_, &pred_); }
+
+	bool empty() const { return begin() == end(); }
+
+private:
+	Iter first_;
+	Iter last_;
+	Pred pred_;
+};
+
+
+// Lazy view of full-order range [first, last) with values mapped by function, see filtered_forest_view
+template<typename Iter, typename Func>
+class transformed_forest_view
+{
+public:
+	using iterator = transform_fullorder_iterator<Iter, Func>;
+	using child_iterator = ::child_iterator<iterator>;
+	using preorder_iterator = edge_iterator<iterator, forest_edge::leading>;
+	using postorder_iterator = edge_iterator<iterator, forest_edge::trailing>;
+
+	explicit transformed_forest_view(Iter first, Iter last, Func func)
+		: first_{ first }, last_{ last }, func_{ std::move(func) } {}
+
+	iterator begin() const { return iterator(first_, &func_); }
+	iterator end() const { return iterator(last_, &func_); }
+
+	bool empty() const { return first_ == last_; }
+
+private:
+	Iter first_;
+	Iter last_;
+	Func func_;
+};
+
+
+template<forest_filter Filter = forest_filter::prune_subtree, typename Iter, typename Pred>
+filtered_forest_view<Iter, Pred, Filter> filtered_view(Iter first, Iter last, Pred pred)
+{
+	return filtered_forest_view<Iter, Pred, Filter>(first, last, std::move(pred));
+}
+
+template<forest_filter Filter = forest_filter::prune_subtree, typename Forest, typename Pred>
+auto filtered_view(Forest& f, Pred pred) { return filtered_view<Filter>(f.begin(), f.end(), std::move(pred)); }
+
+template<typename Iter, typename Func>
+transformed_forest_view<Iter, Func> transformed_view(Iter first, Iter last, Func func)
+{
+	return transformed_forest_view<Iter, Func>(first, last, std::move(func));
+}
+
+template<typename Forest, typename Func>
+auto transformed_view(Forest& f, Func func) { return transformed_view(f.begin(), f.end(), std::move(func)); }
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "forest.hpp"
+
+#include <vector>
+#include <cassert>
+#include <utility>
+#include <iterator>
+
+
+template<typename T>
+class frozen_forest;
+
+namespace frozen_forest_impl
+{
+
+	/*
+		Full-order iterator over frozen_forest.
+		Like forest iterators it walks a cycle: end() is the trailing edge of the invisible tail node
+		and its leading edge (root) precedes begin(), so edge adaptors work unchanged.
+	*/
+	template<typename T>
+	class frozen_forest_iterator
+	{
+		friend class frozen_forest<T>;
+
+		static constexpr std::size_t root_position = static_cast<std::size_t>(-1);
+
+		explicit frozen_forest_iterator(const frozen_forest<T>* f, std::size_t pos)
+			: forest_{ f }, pos_{ pos } {}
+
+	public:
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+		using iterator_category = std::bidirectional_iterator_tag;
+
+		frozen_forest_iterator() : forest_{ nullptr }, pos_{ root_position } {}
+
+		forest_edge edge() const
+		{
+			if (pos_ == root_position) return forest_edge::leading;
+			if (pos_ == forest_->edges_count()) return forest_edge::trailing;
+			return forest_->edge_at(pos_);
+		}
+
+		bool is_leading() const { return edge() == forest_edge::leading; }
+		bool is_trailing() const { return edge() == forest_edge::trailing; }
+
+		// O(1) jumps between edges of the same node
+		void make_leading()
+		{
+			if (pos_ == forest_->edges_count()) pos_ = root_position;
+			else if (pos_ != root_position) pos_ = forest_->leading_position(forest_->node_at(pos_));
+		}
+
+		void make_trailing()
+		{
+			if (pos_ == root_position) pos_ = forest_->edges_count();
+			else if (pos_ != forest_->edges_count()) pos_ = forest_->trailing_position(forest_->node_at(pos_));
+		}
+
+		bool equal_node(const frozen_forest_iterator& other) const { return node() == other.node(); }
+
+		// Position of the node in preorder, the tail node has position equal to forest size
+		std::size_t node() const
+		{
+			return (pos_ == root_position || pos_ == forest_->edges_count()) ? forest_->size() : forest_->node_at(pos_);
+		}
+
+		const T& operator*() const { return forest_->value_at(node()); }
+		const T* operator->() const { return &(**this); }
+
+		frozen_forest_iterator& operator++()
+		{
+			pos_ = (pos_ == forest_->edges_count()) ? root_position : pos_ + 1;
+			return *this;
+		}
+
+		frozen_forest_iterator& operator--()
+		{
+			pos_ = (pos_ == root_position) ? forest_->edges_count() : pos_ - 1;
+			return *this;
+		}
+
+		frozen_forest_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+		frozen_forest_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+		friend bool operator==(const frozen_forest_iterator& lhs, const frozen_forest_iterator& rhs)
+		{
+			return lhs.pos_ == rhs.pos_;
+		}
+		friend bool operator!=(const frozen_forest_iterator& lhs, const frozen_forest_iterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+		const frozen_forest<T>* forest_;
+		std::size_t pos_;
+	};
+
+}
+
+
+/*
+	Read-only snapshot of forest<T> laid out in contiguous arrays.
+	Values are stored in preorder, full-order edge sequence refers to them by position,
+	and every node knows positions of both its edges. Iteration is a linear scan
+	and skipping a subtree (trailing_of/leading_of) is O(1).
+*/
+template<typename T>
+class frozen_forest
+{
+	friend class frozen_forest_impl::frozen_forest_iterator<T>;
+
+public:
+	using value_type = T;
+	using const_pointer = const T*;
+	using const_reference = const T&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	using const_iterator = frozen_forest_impl::frozen_forest_iterator<T>;
+	using iterator = const_iterator;
+
+	using const_child_iterator = child_iterator<const_iterator>;
+
+	using const_preorder_iterator = edge_iterator<const_iterator, forest_edge::leading>;
+	using preorder_iterator = const_preorder_iterator;
+
+	using const_postorder_iterator = edge_iterator<const_iterator, forest_edge::trailing>;
+	using postorder_iterator = const_postorder_iterator;
+
+	frozen_forest() = default;
+	template<forest_augmentation Augmentation>
+	explicit frozen_forest(const forest<T, Augmentation>& f) { build(f.begin(), f.end(), f.size()); }
+	template<forest_augmentation Augmentation>
+	explicit frozen_forest(forest<T, Augmentation>&& f) { build(f.begin(), f.end(), f.size()); f.clear(); }
+
+	size_type size() const { return std::size(values_); }
+	bool empty() const { return values_.empty(); }
+
+	const_iterator root() const { return const_iterator(this, const_iterator::root_position); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, edges_count()); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+
+	// Count of nodes in the subtree of the node
+	size_type subtree_size(const_iterator it) const
+	{
+		const std::size_t n = it.node();
+		return (trailing_[n] - leading_[n] + 1) / 2;
+	}
+
+	// Values in preorder
+	const T* data() const { return std::data(values_); }
+
+private:
+	template<typename Iter>
+	void build(Iter first, Iter last, std::size_t count)
+	{
+		values_.reserve(count);
+		leading_.reserve(count);
+		trailing_.assign(count, 0);
+		edges_.reserve(2 * count);
+
+		std::vector<std::size_t> opened;
+		for (; first != last; ++first)
+		{
+			if (first.is_leading())
+			{
+				const std::size_t n = std::size(values_);
+				values_.emplace_back(std::move_if_noexcept(*first));
+				leading_.emplace_back(std::size(edges_));
+				edges_.emplace_back(n << 1);
+				opened.emplace_back(n);
+			}
+			else
+			{
+				const std::size_t n = opened.back();
+				opened.pop_back();
+				trailing_[n] = std::size(edges_);
+				edges_.emplace_back((n << 1) | 1);
+			}
+		}
+
+		assert(opened.empty());
+	}
+
+	std::size_t edges_count() const { return std::size(edges_); }
+	std::size_t node_at(std::size_t pos) const { return edges_[pos] >> 1; }
+	forest_edge edge_at(std::size_t pos) const { return (edges_[pos] & 1) ? forest_edge::trailing : forest_edge::leading; }
+	std::size_t leading_position(std::size_t n) const { return leading_[n]; }
+	std::size_t trailing_position(std::size_t n) const { return trailing_[n]; }
+	const T& value_at(std::size_t n) const { return values_[n]; }
+
+private:
+	std::vector<T> values_;
+	std::vector<std::size_t> leading_;
+	std::vector<std::size_t> trailing_;
+	// Node position shifted left with trailing flag in the lowest bit
+	std::vector<std::size_t> edges_;
+};
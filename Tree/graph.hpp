@@ -2,54 +2,62 @@
 
 #include "registry.hpp"
 
+#include <map>
+#include <list>
+#include <bitset>
 #include <vector>
+#include <unordered_set>
 #include <cassert>
 #include <algorithm>
 #include <stdexcept>
 #include <limits>
 
 
-class graph_node
+template<typename Index>
+class basic_graph_node
 {
 public:
-	explicit graph_node(std::size_t index) : index_{ index } { }
-	std::size_t index() const { return index_; }
+	explicit basic_graph_node(Index index) : index_{ index } { }
+	Index index() const { return index_; }
 
-	friend bool operator==(const graph_node& lhs, const graph_node& rhs) { return lhs.index() == rhs.index(); }
-	friend bool operator!=(const graph_node& lhs, const graph_node& rhs) { return lhs.index() != rhs.index(); }
+	friend bool operator==(const basic_graph_node& lhs, const basic_graph_node& rhs) { return lhs.index() == rhs.index(); }
+	friend bool operator!=(const basic_graph_node& lhs, const basic_graph_node& rhs) { return lhs.index() != rhs.index(); }
 
-	friend bool operator<(const graph_node& lhs, const graph_node& rhs) { return lhs.index() < rhs.index(); }
-	friend bool operator>(const graph_node& lhs, const graph_node& rhs) { return lhs.index() > rhs.index(); }
+	friend bool operator<(const basic_graph_node& lhs, const basic_graph_node& rhs) { return lhs.index() < rhs.index(); }
+	friend bool operator>(const basic_graph_node& lhs, const basic_graph_node& rhs) { return lhs.index() > rhs.index(); }
 
-	friend bool operator<=(const graph_node& lhs, const graph_node& rhs) { return lhs.index() <= rhs.index(); }
-	friend bool operator>=(const graph_node& lhs, const graph_node& rhs) { return lhs.index() >= rhs.index(); }
+	friend bool operator<=(const basic_graph_node& lhs, const basic_graph_node& rhs) { return lhs.index() <= rhs.index(); }
+	friend bool operator>=(const basic_graph_node& lhs, const basic_graph_node& rhs) { return lhs.index() >= rhs.index(); }
 
 private:
-	std::size_t index_;
+	Index index_;
 };
 
+using graph_node = basic_graph_node<std::size_t>;
+
 
 namespace graph_impl
 {
 
+	template<typename Index>
 	class inner_node
 	{
 	public:
-		void add_neighbor(std::size_t nodeIndex)
+		void add_neighbor(Index nodeIndex)
 		{
-			assert(std::find(std::cbegin(neighbors_), std::cend(neighbors_), graph_node(nodeIndex)) == std::cend(neighbors_));
+			assert(std::find(std::cbegin(neighbors_), std::cend(neighbors_), basic_graph_node<Index>(nodeIndex)) == std::cend(neighbors_));
 			neighbors_.emplace_back(nodeIndex);
 		}
 
-		std::vector<graph_node>& neighbors() { return neighbors_; }
-		const std::vector<graph_node>& neighbors() const { return neighbors_; }
+		std::vector<basic_graph_node<Index>>& neighbors() { return neighbors_; }
+		const std::vector<basic_graph_node<Index>>& neighbors() const { return neighbors_; }
 
 	private:
-		std::vector<graph_node> neighbors_;
+		std::vector<basic_graph_node<Index>> neighbors_;
 	};
 	
-	template<typename T>
-	class inner_data_node : public inner_node
+	template<typename T, typename Index>
+	class inner_data_node : public inner_node<Index>
 	{
 	public:
 		template<typename... Args>
@@ -62,59 +70,234 @@ namespace graph_impl
 		T value_;
 	};
 
+
+	// Nodes within k hops of the source (source excluded), sorted by index.
+	template<typename Node>
+	struct neighborhood
+	{
+		Node source;
+		std::size_t hops;
+		std::vector<Node> nodes;
+		std::vector<std::size_t> depths;
+
+		// Distance from source to n if it is less than hops
+		bool is_inner(const Node& n) const
+		{
+			if (n == source) return hops > 0;
+
+			const auto it = std::lower_bound(std::cbegin(nodes), std::cend(nodes), n);
+			return it != std::cend(nodes) && *it == n && depths[it - std::cbegin(nodes)] < hops;
+		}
+	};
+
+	// Bounded LRU cache of k-hop neighborhoods
+	template<typename Node>
+	class neighborhood_cache
+	{
+	public:
+		explicit neighborhood_cache(std::size_t capacity) : capacity_{ capacity } {}
+
+		// Index points into the list, so a copy has to rebuild it against its own entries
+		neighborhood_cache(const neighborhood_cache& other)
+			: capacity_{ other.capacity_ }
+			, hits_{ other.hits_ }
+			, misses_{ other.misses_ }
+			, entries_{ other.entries_ }
+		{
+			for (auto it = std::begin(entries_); it != std::end(entries_); ++it)
+				index_[key_type(it->source.index(), it->hops)] = it;
+		}
+
+		neighborhood_cache(neighborhood_cache&&) = default;
+
+		neighborhood_cache& operator=(const neighborhood_cache& other)
+		{
+			if (this != &other)
+			{
+				neighborhood_cache copy(other);
+				*this = std::move(copy);
+			}
+
+			return *this;
+		}
+
+		neighborhood_cache& operator=(neighborhood_cache&&) = default;
+
+		std::size_t capacity() const { return capacity_; }
+		void set_capacity(std::size_t capacity)
+		{
+			capacity_ = capacity;
+			while (std::size(entries_) > capacity_) evict();
+		}
+
+		std::size_t hits() const { return hits_; }
+		std::size_t misses() const { return misses_; }
+		std::size_t size() const { return std::size(entries_); }
+
+		const neighborhood<Node>* find(const Node& source, std::size_t hops)
+		{
+			const auto it = index_.find(key_type(source.index(), hops));
+			if (it == std::end(index_))
+			{
+				++misses_;
+				return nullptr;
+			}
+
+			++hits_;
+			entries_.splice(std::begin(entries_), entries_, it->second);
+			return &entries_.front();
+		}
+
+		void insert(neighborhood<Node> n)
+		{
+			if (capacity_ == 0) return;
+			if (std::size(entries_) == capacity_) evict();
+
+			const key_type key(n.source.index(), n.hops);
+			entries_.emplace_front(std::move(n));
+			index_[key] = std::begin(entries_);
+		}
+
+		// Drops every entry whose result may change when an edge is attached to n,
+		// i.e. entries where n lies strictly within k hops from the source.
+		void invalidate(const Node& n)
+		{
+			for (auto it = std::begin(entries_); it != std::end(entries_);)
+			{
+				if (it->is_inner(n))
+				{
+					index_.erase(key_type(it->source.index(), it->hops));
+					it = entries_.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+	private:
+		using key_type = std::pair<std::size_t, std::size_t>;
+
+		void evict()
+		{
+			const auto& last = entries_.back();
+			index_.erase(key_type(last.source.index(), last.hops));
+			entries_.pop_back();
+		}
+
+	private:
+		std::size_t capacity_;
+		std::size_t hits_ = 0;
+		std::size_t misses_ = 0;
+		std::list<neighborhood<Node>> entries_;
+		std::map<key_type, typename std::list<neighborhood<Node>>::iterator> index_;
+	};
+
 }
 
 
-template<typename T>
+template<typename T, typename Index = std::size_t>
 class graph
 {
-	friend class graph_node;
 public:
-	using node_iterator = std::vector<graph_node>::iterator;
-	using const_node_iterator = std::vector<graph_node>::const_iterator;
+	using node_type = basic_graph_node<Index>;
+	using node_iterator = typename std::vector<node_type>::iterator;
+	using const_node_iterator = typename std::vector<node_type>::const_iterator;
 
 	template<typename... Args>
-	graph_node emplace_node(Args&&... args) 
+	node_type emplace_node(Args&&... args) 
 	{ 
-		return graph_node(nodes_.emplace(std::forward<Args>(args)...));
+		return node_type(nodes_.emplace(std::forward<Args>(args)...));
 	}
 
 	template<typename... Args>
-	graph_node emplace_neigbor(const graph_node& node, Args&&... args)
+	node_type emplace_neigbor(const node_type& node, Args&&... args)
 	{
 		const auto lastNodeIndex = nodes_.emplace(std::forward<Args>(args)...);
 		node_at(node.index()).add_neighbor(lastNodeIndex);
 		node_at(lastNodeIndex).add_neighbor(node.index());
-		return graph_node(lastNodeIndex);
+		cache_.invalidate(node);
+		return node_type(lastNodeIndex);
 	}
 
-	void make_neighbors(const graph_node& node, const graph_node& neighbor)
+	void make_neighbors(const node_type& node, const node_type& neighbor)
 	{
 		if (node == neighbor)
 			throw std::invalid_argument("node can't be self neigbor");
 
 		node_at(node.index()).add_neighbor(neighbor.index());
 		node_at(neighbor.index()).add_neighbor(node.index());
+		cache_.invalidate(node);
+		cache_.invalidate(neighbor);
+	}
+
+	// Nodes reachable from n in at most k hops (n excluded), sorted by index.
+	// Results are kept in a bounded LRU cache until an edge is added within k hops.
+	// Every call updates the cache, so like other modifying calls it needs
+	// external synchronization when the graph is shared between threads.
+	std::vector<node_type> neighborhood_of(const node_type& n, std::size_t k)
+	{
+		if (const auto* cached = cache_.find(n, k))
+			return cached->nodes;
+
+		std::vector<std::pair<node_type, std::size_t>> visited{ { n, 0 } };
+		std::unordered_set<Index> seen{ n.index() };
+		for (std::size_t i = 0; i < std::size(visited) && visited[i].second < k; ++i)
+		{
+			const auto [current, depth] = visited[i];
+			for (const node_type neighbor : node_at(current.index()).neighbors())
+				if (seen.insert(neighbor.index()).second)
+					visited.emplace_back(neighbor, depth + 1);
+		}
+
+		std::sort(std::begin(visited) + 1, std::end(visited));
+
+		graph_impl::neighborhood<node_type> result{ n, k, {}, {} };
+		result.nodes.reserve(std::size(visited) - 1);
+		result.depths.reserve(std::size(visited) - 1);
+		for (auto it = std::next(std::cbegin(visited)); it != std::cend(visited); ++it)
+		{
+			result.nodes.emplace_back(it->first);
+			result.depths.emplace_back(it->second);
+		}
+
+		std::vector<node_type> nodes = result.nodes;
+		cache_.insert(std::move(result));
+		return nodes;
 	}
 
-	const T& value_of(const graph_node& n) const { return nodes_.value(n.index()).value(); }
-	T& value_of(const graph_node& n) { return nodes_.value(n.index()).value(); }
+	void set_neighborhood_cache_capacity(std::size_t capacity) { cache_.set_capacity(capacity); }
+	std::size_t neighborhood_cache_capacity() const { return cache_.capacity(); }
+	std::size_t neighborhood_cache_hits() const { return cache_.hits(); }
+	std::size_t neighborhood_cache_misses() const { return cache_.misses(); }
+
+	std::size_t size() const { return nodes_.size(); }
 
-	node_iterator begin(const graph_node& n) { return std::begin(node_at(n.index()).neighbors()); }
-	node_iterator end(const graph_node& n) { return std::end(node_at(n.index()).neighbors()); }
+	// All node indices are less than this value
+	std::size_t index_bound() const { return nodes_.id_bound(); }
 
-	const_node_iterator cbegin(const graph_node& n) const { return std::begin(node_at(n.index()).neighbors()); }
-	const_node_iterator cend(const graph_node& n) const { return std::end(node_at(n.index()).neighbors()); }
+	template<typename Func>
+	void for_each_node(Func func) const { nodes_.for_each_id([&func](Index index) { func(node_type(index)); }); }
 
-	const_node_iterator begin(const graph_node& n) const { return cbegin(n); }
-	const_node_iterator end(const graph_node& n) const { return cend(n); }
+	const T& value_of(const node_type& n) const { return nodes_.value(n.index()).value(); }
+	T& value_of(const node_type& n) { return nodes_.value(n.index()).value(); }
+
+	node_iterator begin(const node_type& n) { return std::begin(node_at(n.index()).neighbors()); }
+	node_iterator end(const node_type& n) { return std::end(node_at(n.index()).neighbors()); }
+
+	const_node_iterator cbegin(const node_type& n) const { return std::begin(node_at(n.index()).neighbors()); }
+	const_node_iterator cend(const node_type& n) const { return std::end(node_at(n.index()).neighbors()); }
+
+	const_node_iterator begin(const node_type& n) const { return cbegin(n); }
+	const_node_iterator end(const node_type& n) const { return cend(n); }
 
 
 	class node_range
 	{
 		friend graph;
 
-		explicit node_range(graph* pGraph, graph_node n)
+		explicit node_range(graph* pGraph, node_type n)
 			: pGraph_{pGraph}
 			, node_{n}
 		{ assert(pGraph_ != nullptr); }
@@ -128,14 +311,14 @@ public:
 
 	private:
 		graph* pGraph_;
-		graph_node node_;
+		node_type node_;
 	};
 
 	class const_node_range
 	{
 		friend graph;
 
-		explicit const_node_range(graph* pGraph, graph_node n)
+		explicit const_node_range(const graph* pGraph, node_type n)
 			: pGraph_{ pGraph }
 			, node_{ n }
 		{ assert(pGraph_ != nullptr); }
@@ -148,17 +331,253 @@ public:
 		const_node_iterator end() const { return pGraph_->end(node_); }
 
 	private:
-		graph* pGraph_;
-		graph_node node_;
+		const graph* pGraph_;
+		node_type node_;
 	};
 
-	node_range neighbors_of(const graph_node& n) { return node_range(this, n); }
-	const_node_range neighbors_of(const graph_node& n) const { return const_node_range(this, n); }
+	node_range neighbors_of(const node_type& n) { return node_range(this, n); }
+	const_node_range neighbors_of(const node_type& n) const { return const_node_range(this, n); }
 
 private:
-	const graph_impl::inner_node& node_at(std::size_t index) const { return nodes_.value(index); }
-	graph_impl::inner_node& node_at(std::size_t index) { return nodes_.value(index); }
+	const graph_impl::inner_node<Index>& node_at(Index index) const { return nodes_.value(index); }
+	graph_impl::inner_node<Index>& node_at(Index index) { return nodes_.value(index); }
 
 private:
-	registry<graph_impl::inner_data_node<T>> nodes_;
+	registry<graph_impl::inner_data_node<T, Index>, Index> nodes_;
+	graph_impl::neighborhood_cache<node_type> cache_{ 256 };
+};
+
+
+namespace graph_impl
+{
+
+	// Immutable compressed adjacency of the graph. Nodes are renumbered densely,
+	// neighbors of dense node i are targets[offsets[i]..offsets[i + 1]).
+	template<typename Index>
+	struct adjacency_snapshot
+	{
+		template<typename T>
+		explicit adjacency_snapshot(const graph<T, Index>& gr)
+			: dense(gr.index_bound(), null_index)
+		{
+			nodes.reserve(gr.size());
+			gr.for_each_node([this](basic_graph_node<Index> n) { dense[n.index()] = static_cast<Index>(std::size(nodes)); nodes.emplace_back(n); });
+
+			offsets.reserve(std::size(nodes) + 1);
+			offsets.emplace_back(0);
+			for (const auto n : nodes)
+			{
+				for (const auto neighbor : gr.neighbors_of(n))
+					targets.emplace_back(dense[neighbor.index()]);
+
+				offsets.emplace_back(std::size(targets));
+			}
+		}
+
+		static constexpr auto null_index = std::numeric_limits<Index>::max();
+
+		std::vector<basic_graph_node<Index>> nodes;
+		std::vector<Index> dense;
+		std::vector<std::size_t> offsets;
+		std::vector<Index> targets;
+	};
+
+}
+
+
+/*
+	Multi-source breadth-first search (MS-BFS).
+	Sources are processed in batches of BatchSize, each node keeps a bitset
+	with one bit per source of the batch, so one pass over the edges advances
+	BFS from all sources of the batch at once.
+
+	func(node, depth, batchFirst, reached) is called once per node and level,
+	bit i of reached is set if sources[batchFirst + i] reaches node first at depth.
+*/
+template<std::size_t BatchSize = 64, typename T, typename Index, typename Func>
+void multi_source_bfs(const graph<T, Index>& gr, const std::vector<basic_graph_node<Index>>& sources, Func&& func)
+{
+	using bitset = std::bitset<BatchSize>;
+
+	const graph_impl::adjacency_snapshot<Index> adjacency(gr);
+	const std::size_t count = std::size(adjacency.nodes);
+
+	std::vector<bitset> seen(count);
+	std::vector<bitset> visit(count);
+	std::vector<bitset> visitNext(count);
+
+	for (std::size_t batchFirst = 0; batchFirst < std::size(sources); batchFirst += BatchSize)
+	{
+		const std::size_t batchLast = std::min(std::size(sources), batchFirst + BatchSize);
+
+		std::fill(std::begin(seen), std::end(seen), bitset());
+		std::fill(std::begin(visit), std::end(visit), bitset());
+
+		for (std::size_t i = batchFirst; i < batchLast; ++i)
+		{
+			const std::size_t v = adjacency.dense.at(sources[i].index());
+			if (v == graph_impl::adjacency_snapshot<Index>::null_index)
+				throw std::invalid_argument("source node not found");
+
+			seen[v].set(i - batchFirst);
+			visit[v].set(i - batchFirst);
+		}
+
+		for (std::size_t v = 0; v < count; ++v)
+			if (visit[v].any()) func(adjacency.nodes[v], std::size_t(0), batchFirst, visit[v]);
+
+		for (std::size_t depth = 1; ; ++depth)
+		{
+			std::fill(std::begin(visitNext), std::end(visitNext), bitset());
+			for (std::size_t v = 0; v < count; ++v)
+			{
+				if (visit[v].none()) continue;
+
+				for (std::size_t e = adjacency.offsets[v]; e < adjacency.offsets[v + 1]; ++e)
+					visitNext[adjacency.targets[e]] |= visit[v];
+			}
+
+			bool advanced = false;
+			for (std::size_t v = 0; v < count; ++v)
+			{
+				bitset& next = visitNext[v];
+				if (next.none()) continue;
+
+				next &= ~seen[v];
+				if (next.none()) continue;
+
+				seen[v] |= next;
+				advanced = true;
+				func(adjacency.nodes[v], depth, batchFirst, next);
+			}
+
+			if (!advanced) break;
+			visit.swap(visitNext);
+		}
+	}
+}
+
+
+/*
+	Result of graph partitioning.
+	Nodes of partition p are stored contiguously: order[offsets[p]..offsets[p + 1]),
+	so parallel algorithms can process partitions independently.
+*/
+template<typename Index = std::size_t>
+struct graph_partition
+{
+	static constexpr auto null_part = std::numeric_limits<std::size_t>::max();
+
+	std::size_t parts_count() const { return std::size(offsets) - 1; }
+	std::size_t part_of(const basic_graph_node<Index>& n) const { return parts.at(n.index()); }
+
+	typename std::vector<basic_graph_node<Index>>::const_iterator begin(std::size_t part) const { return std::cbegin(order) + offsets.at(part); }
+	typename std::vector<basic_graph_node<Index>>::const_iterator end(std::size_t part) const { return std::cbegin(order) + offsets.at(part + 1); }
+
+	std::vector<std::size_t> parts;		// partition id by node index
+	std::vector<basic_graph_node<Index>> order;		// nodes grouped by partition
+	std::vector<std::size_t> offsets;	// start of each partition in order
 };
+
+
+/*
+	Balanced label propagation partitioning.
+	Nodes are seeded into partsCount BFS-grown regions, then every node
+	repeatedly moves to the partition most of its neighbors belong to unless
+	it would exceed the size limit of (1 + imbalance) * size / partsCount.
+*/
+template<typename T, typename Index>
+graph_partition<Index> partition_graph(const graph<T, Index>& gr, std::size_t partsCount, std::size_t iterations = 10, double imbalance = 0.05)
+{
+	if (partsCount == 0)
+		throw std::invalid_argument("parts count must be positive");
+
+	const graph_impl::adjacency_snapshot<Index> adjacency(gr);
+	const std::size_t count = std::size(adjacency.nodes);
+
+	const std::size_t chunk = std::max<std::size_t>(1, (count + partsCount - 1) / partsCount);
+	const auto limit = std::max<std::size_t>(chunk, static_cast<std::size_t>(chunk * (1.0 + imbalance)));
+
+	// Seed partitions by growing BFS regions of chunk nodes over unassigned nodes
+	std::vector<std::size_t> labels(count, graph_partition<Index>::null_part);
+	std::vector<std::size_t> sizes(partsCount, 0);
+	std::vector<std::size_t> seedOrder;
+	seedOrder.reserve(count);
+	for (std::size_t root = 0; root < count; ++root)
+	{
+		if (labels[root] != graph_partition<Index>::null_part) continue;
+
+		const std::size_t part = std::size(seedOrder) / chunk;
+		labels[root] = part;
+		seedOrder.emplace_back(root);
+		for (std::size_t i = std::size(seedOrder) - 1; i < std::size(seedOrder) && std::size(seedOrder) < (part + 1) * chunk; ++i)
+		{
+			for (std::size_t e = adjacency.offsets[seedOrder[i]]; e < adjacency.offsets[seedOrder[i] + 1] && std::size(seedOrder) < (part + 1) * chunk; ++e)
+			{
+				const std::size_t target = adjacency.targets[e];
+				if (labels[target] == graph_partition<Index>::null_part)
+				{
+					labels[target] = part;
+					seedOrder.emplace_back(target);
+				}
+			}
+		}
+	}
+
+	for (const std::size_t label : labels) ++sizes[label];
+
+	std::vector<std::size_t> votes(partsCount, 0);
+	std::vector<std::size_t> candidates;
+	for (std::size_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		bool moved = false;
+		for (const std::size_t v : seedOrder)
+		{
+			for (std::size_t e = adjacency.offsets[v]; e < adjacency.offsets[v + 1]; ++e)
+			{
+				const std::size_t label = labels[adjacency.targets[e]];
+				if (votes[label]++ == 0) candidates.emplace_back(label);
+			}
+
+			const std::size_t current = labels[v];
+			std::size_t best = current;
+			for (const std::size_t label : candidates)
+			{
+				if (label != current && sizes[label] < limit && votes[label] > votes[best])
+					best = label;
+			}
+
+			for (const std::size_t label : candidates) votes[label] = 0;
+			candidates.clear();
+
+			if (best != current)
+			{
+				--sizes[current];
+				++sizes[best];
+				labels[v] = best;
+				moved = true;
+			}
+		}
+
+		if (!moved) break;
+	}
+
+	graph_partition<Index> result;
+	result.parts.assign(gr.index_bound(), graph_partition<Index>::null_part);
+	result.offsets.assign(partsCount + 1, 0);
+	for (std::size_t v = 0; v < count; ++v)
+	{
+		result.parts[adjacency.nodes[v].index()] = labels[v];
+		++result.offsets[labels[v] + 1];
+	}
+
+	for (std::size_t p = 0; p < partsCount; ++p)
+		result.offsets[p + 1] += result.offsets[p];
+
+	std::vector<std::size_t> positions(std::cbegin(result.offsets), std::cend(result.offsets) - 1);
+	result.order.resize(count, basic_graph_node<Index>(0));
+	for (const std::size_t v : seedOrder)
+		result.order[positions[labels[v]]++] = adjacency.nodes[v];
+
+	return result;
+}
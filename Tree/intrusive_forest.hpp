@@ -0,0 +1,337 @@
+#pragma once
+
+#include "forest.hpp"
+
+#include <vector>
+#include <cassert>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+
+
+template<typename T>
+class intrusive_forest;
+
+// Hook which user types derive from to be linked into intrusive_forest: struct item : forest_node_base<item> { ... };
+template<typename T>
+using forest_node_base = forest_impl::forest_node_base<T>;
+
+namespace forest_impl
+{
+
+	// Full-order iterator over intrusive_forest, Node is T or const T
+	template<typename Node>
+	class intrusive_forest_iterator
+	{
+		using node = std::remove_const_t<Node>;
+
+		friend struct set_next_functor<intrusive_forest_iterator<Node>>;
+		friend class intrusive_forest<node>;
+		friend class intrusive_forest_iterator<const node>;
+
+		explicit intrusive_forest_iterator(node* n, forest_edge edge)
+			: node_{ n }, edge_{ edge } { assert(n != nullptr); }
+
+	public:
+		using value_type = node;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Node*;
+		using reference = Node&;
+		using iterator_category = std::bidirectional_iterator_tag;
+
+		intrusive_forest_iterator() : node_{ nullptr }, edge_{ forest_edge::leading } {}
+
+		template<typename U, typename = std::enable_if_t<std::is_const_v<Node> && std::is_same_v<U, node>>>
+		intrusive_forest_iterator(const intrusive_forest_iterator<U>& other) : node_{ other.node_ }, edge_{ other.edge_ } {}
+
+		forest_edge edge() const { return edge_; }
+
+		bool is_leading() const { return edge_ == forest_edge::leading; }
+		bool is_trailing() const { return edge_ == forest_edge::trailing; }
+
+		void make_leading() { edge_ = forest_edge::leading; }
+		void make_trailing() { edge_ = forest_edge::trailing; }
+
+		bool equal_node(const intrusive_forest_iterator& other) const { return node_ == other.node_; }
+
+		Node& operator*() const { return *node_; }
+		Node* operator->() const { return node_; }
+
+		intrusive_forest_iterator& operator++()
+		{
+			forest_impl::increment_edge(node_, edge_);
+			return *this;
+		}
+
+		intrusive_forest_iterator& operator--()
+		{
+			forest_impl::decrement_edge(node_, edge_);
+			return *this;
+		}
+
+		intrusive_forest_iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+		intrusive_forest_iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+
+		friend bool operator==(const intrusive_forest_iterator& lhs, const intrusive_forest_iterator& rhs)
+		{
+			return lhs.node_ == rhs.node_ && lhs.edge_ == rhs.edge_;
+		}
+		friend bool operator!=(const intrusive_forest_iterator& lhs, const intrusive_forest_iterator& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+	private:
+		node* node_;
+		forest_edge edge_;
+	};
+
+	template<typename Node>
+	struct set_next_functor<intrusive_forest_iterator<Node>> {
+		void operator()(intrusive_forest_iterator<Node> prev, intrusive_forest_iterator<Node> next) {
+			prev.node_->get(prev.edge_).next = next.node_;
+			next.node_->get(next.edge_).prev = prev.node_;
+		}
+	};
+
+}
+
+
+/*
+	Forest of nodes owned by the caller: T derives from forest_node_base<T>
+	and is linked in place, without allocation or copying.
+	A node can be in one forest at a time and has to outlive its membership.
+	Unlinked nodes (erase, clear, destructor) are reset and may be inserted again,
+	so clear() and the destructor walk all nodes.
+*/
+template<typename T>
+class intrusive_forest
+{
+	static_assert(std::is_base_of_v<forest_impl::forest_node_base<T>, T>, "T has to derive from forest_node_base<T>");
+
+public:
+	using value_type = T;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using reference = T&;
+	using const_reference = const T&;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+
+	using iterator = forest_impl::intrusive_forest_iterator<T>;
+	using const_iterator = forest_impl::intrusive_forest_iterator<const T>;
+
+	using const_child_iterator = ::child_iterator<const_iterator>;
+	using child_iterator = ::child_iterator<iterator>;
+
+	using preorder_iterator = edge_iterator<iterator, forest_edge::leading>;
+	using const_preorder_iterator = edge_iterator<const_iterator, forest_edge::leading>;
+
+	using postorder_iterator = edge_iterator<iterator, forest_edge::trailing>;
+	using const_postorder_iterator = edge_iterator<const_iterator, forest_edge::trailing>;
+
+	intrusive_forest() : size_{ 0 }, tail_() {}
+	~intrusive_forest() { clear(); }
+
+	intrusive_forest(const intrusive_forest&) = delete;
+	intrusive_forest& operator=(const intrusive_forest&) = delete;
+
+	intrusive_forest(intrusive_forest&& other) noexcept : intrusive_forest() { swap(other); }
+	intrusive_forest& operator=(intrusive_forest&& other) noexcept
+	{
+		intrusive_forest tmp(std::move(other));
+		swap(tmp);
+		return *this;
+	}
+
+	void swap(intrusive_forest& other) noexcept
+	{
+		T* first = tail_.leading().next;
+		T* last = tail_.trailing().prev;
+		T* otherFirst = other.tail_.leading().next;
+		T* otherLast = other.tail_.trailing().prev;
+
+		if (first == tail()) first = last = nullptr;
+		if (otherFirst == other.tail()) otherFirst = otherLast = nullptr;
+
+		attach_roots(otherFirst, otherLast);
+		other.attach_roots(first, last);
+		std::swap(size_, other.size_);
+	}
+
+	size_type size() const { return size_; }
+	bool empty() const { return begin() == end(); }
+
+	void clear()
+	{
+		for (iterator first = begin(), last = end(); first != last;)
+		{
+			T* current = first.node_;
+			const bool trailing = first.is_trailing();
+			++first;
+			if (trailing) current->reset();
+		}
+
+		tail_.reset();
+		size_ = 0;
+	}
+
+	// Links unlinked node x before pos
+	iterator insert(const_iterator pos, T& x)
+	{
+		assert(!x.is_linked());
+
+		const iterator where(mutable_node(pos), pos.edge());
+		iterator result(&x, forest_edge::leading);
+		forest_impl::set_next(std::prev(where), result);
+		forest_impl::set_next(std::next(result), where);
+		++size_;
+		return result;
+	}
+
+	// Unlinks node, its children take its place
+	iterator erase(const_iterator pos)
+	{
+		const iterator leading(mutable_node(pos), forest_edge::leading);
+		const iterator trailing(mutable_node(pos), forest_edge::trailing);
+		const iterator leadingPrev = std::prev(leading);
+		const iterator trailingNext = std::next(trailing);
+
+		if (has_children(leading))
+		{
+			forest_impl::set_next(leadingPrev, std::next(leading));
+			forest_impl::set_next(std::prev(trailing), trailingNext);
+		}
+		else
+		{
+			forest_impl::set_next(leadingPrev, trailingNext);
+		}
+
+		const bool wasLeading = pos.is_leading();
+		leading.node_->reset();
+		--size_;
+
+		return wasLeading ? std::next(leadingPrev) : trailingNext;
+	}
+
+	// Unlinks nodes whose both edges lie in [first, last), see forest::erase
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		const iterator end(mutable_node(last), last.edge());
+		std::vector<T*> opened;
+		iterator runPrev = std::prev(iterator(mutable_node(first), first.edge()));
+
+		for (iterator pos(mutable_node(first), first.edge()); pos != end;)
+		{
+			T* current = pos.node_;
+			if (pos.is_leading())
+			{
+				opened.emplace_back(current);
+				++pos;
+				continue;
+			}
+
+			if (opened.empty())
+			{
+				forest_impl::set_next(runPrev, pos);
+				runPrev = pos;
+				++pos;
+				continue;
+			}
+
+			assert(opened.back() == current);
+			opened.pop_back();
+			++pos;
+			current->reset();
+			--size_;
+		}
+
+		for (T* kept : opened)
+		{
+			const iterator leading(kept, forest_edge::leading);
+			forest_impl::set_next(runPrev, leading);
+			runPrev = leading;
+		}
+		forest_impl::set_next(runPrev, end);
+
+		return end;
+	}
+
+	iterator splice(const_iterator pos, intrusive_forest& other)
+	{
+		return splice(pos, other, child_iterator(other.begin()), child_iterator(other.end()), other.size());
+	}
+
+	iterator splice(const_iterator pos, intrusive_forest& other, const_iterator it)
+	{
+		const iterator subtree(mutable_node(it), forest_edge::leading);
+		return splice(pos, other, child_iterator(subtree), ++child_iterator(subtree), has_children(subtree) ? 0 : 1);
+	}
+
+	// Zero count means the number of spliced nodes is unknown and it is counted when nodes move between forests
+	iterator splice(const_iterator position, intrusive_forest& other, child_iterator first, child_iterator last, size_type count = 0)
+	{
+		const iterator pos(mutable_node(position), position.edge());
+		if (first == last || first.base() == pos) return pos;
+
+		if (&other != this)
+		{
+			if (count == 0)
+			{
+				for (iterator it = first.base(), end = last.base(); it != end; ++it)
+					count += it.is_leading() ? 1 : 0;
+			}
+
+			size_ += count;
+			other.size_ -= count;
+		}
+
+		iterator back(std::prev(last.base()));
+		forest_impl::set_next(std::prev(first), last);
+		forest_impl::set_next(std::prev(pos), first.base());
+		forest_impl::set_next(back, pos);
+		return first.base();
+	}
+
+	// Iterator to the leading edge of a node linked into this forest
+	iterator iterator_to(T& x) { assert(x.is_linked()); return iterator(&x, forest_edge::leading); }
+	const_iterator iterator_to(const T& x) const { assert(x.is_linked()); return const_iterator(const_cast<T*>(&x), forest_edge::leading); }
+
+	iterator root() { return iterator(tail(), forest_edge::leading); }
+	const_iterator root() const { return const_iterator(tail(), forest_edge::leading); }
+
+	iterator begin() { return std::next(root()); }
+	iterator end() { return iterator(tail(), forest_edge::trailing); }
+
+	const_iterator cbegin() const { return std::next(root()); }
+	const_iterator cend() const { return const_iterator(tail(), forest_edge::trailing); }
+
+	const_iterator begin() const { return cbegin(); }
+	const_iterator end() const { return cend(); }
+
+private:
+	static T* mutable_node(const_iterator it) { return it.node_; }
+
+	void attach_roots(T* first, T* last)
+	{
+		if (first == nullptr)
+		{
+			tail_.reset();
+			return;
+		}
+
+		tail_.leading().next = first;
+		first->leading().prev = tail();
+		tail_.trailing().prev = last;
+		last->trailing().next = tail();
+	}
+
+	T* tail() const { return static_cast<T*>(&tail_); }
+
+private:
+	size_type size_;
+	mutable forest_impl::forest_node_base<T> tail_;
+};
+
+template <typename T>
+void swap(intrusive_forest<T>& lhs, intrusive_forest<T>& rhs) noexcept { lhs.swap(rhs); }
@@ -1,8 +1,16 @@
 #include "graph.hpp"
+#include "dag.hpp"
 #include "tree.hpp"
 #include "binary_tree.hpp"
 #include "forest.hpp"
-
+#include "frozen_forest.hpp"
+#include "forest_conversions.hpp"
+#include "forest_views.hpp"
+#include "intrusive_forest.hpp"
+
+#include <chrono>
+#include <memory>
+#include <random>
 #include <iostream>
 #include <iterator>
 #include <algorithm>
@@ -28,7 +36,7 @@ struct Printer { void operator()(const std::string& elem) const { std::cout << e
 
 void test_binary_tree()
 {
-	binary_tree<std::string> btree("root");
+	binary_tree<std::string, std::size_t, binary_tree_augmentation::parent_links> btree("root");
 
 	auto root = btree.root();
 	auto left = btree.emplace_left(root, "left");
@@ -45,6 +53,9 @@ void test_binary_tree()
 	std::cout << "\n====== morris_traversal_preorder ======\n";
 	morris_traversal_preorder(btree, root, Printer());
 
+	std::cout << "\n====== stackless_traversal_preorder ======\n";
+	stackless_traversal_preorder(btree, root, Printer());
+
 	std::cout << "\n====== traverse_preorder_recursive ======\n";
 	traverse_preorder_recursive(btree, root, Printer());
 
@@ -54,6 +65,9 @@ void test_binary_tree()
 	std::cout << "\n====== morris_traversal_inorder ======\n";
 	morris_traversal_inorder(btree, root, Printer());
 
+	std::cout << "\n====== stackless_traversal_inorder ======\n";
+	stackless_traversal_inorder(btree, root, Printer());
+
 	std::cout << "\n====== traverse_inorder_recursive ======\n";
 	traverse_inorder_recursive(btree, root, Printer());
 
@@ -63,6 +77,9 @@ void test_binary_tree()
 	std::cout << "\n====== morris_traversal_postorder ======\n";
 	morris_traversal_postorder(btree, Printer());
 
+	std::cout << "\n====== stackless_traversal_postorder ======\n";
+	stackless_traversal_postorder(btree, root, Printer());
+
 	std::cout << "\n====== traverse_postorder_recursive ======\n";
 	traverse_postorder_recursive(btree, root, Printer());
 
@@ -72,6 +89,100 @@ void test_binary_tree()
 	std::cout << std::endl;
 }
 
+void test_binary_tree_ranges()
+{
+	// Default tree has no parent links, ranges keep their own stack
+	binary_tree<int> btree(4);
+	auto root = btree.root();
+	auto left = btree.emplace_left(root, 2);
+	btree.emplace_left(left, 1);
+	btree.emplace_right(left, 3);
+	btree.emplace_right(root, 5);
+
+	const auto equal = [](const auto& range, std::initializer_list<int> expected) {
+		return std::equal(range.begin(), range.end(), std::begin(expected), std::end(expected));
+	};
+
+	assert(equal(preorder_range(btree, root), { 4, 2, 1, 3, 5 }));
+	assert(equal(inorder_range(btree, root), { 1, 2, 3, 4, 5 }));
+	assert(equal(postorder_range(btree, root), { 1, 3, 2, 5, 4 }));
+	assert(equal(inorder_range(btree, left), { 1, 2, 3 }));
+}
+
+template<typename Func>
+void measure(const char* name, Func func)
+{
+	const auto start = std::chrono::steady_clock::now();
+	func();
+	const auto finish = std::chrono::steady_clock::now();
+	std::cout << name << ": " << std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count() << " ms\n";
+}
+
+template<binary_tree_augmentation Augmentation = binary_tree_augmentation::none>
+binary_tree<int, std::size_t, Augmentation> make_random_search_tree(int count, std::mt19937& gen)
+{
+	std::uniform_int_distribution<int> dist(0, count * 4);
+
+	binary_tree<int, std::size_t, Augmentation> btree(count * 2);
+	for (int i = 0; i < count; ++i)
+	{
+		const int key = dist(gen);
+		auto current = btree.root();
+		while (true)
+		{
+			auto next = key < btree.value(current) ? btree.left(current) : btree.right(current);
+			if (!next.is_null()) { current = next; continue; }
+
+			if (key < btree.value(current)) btree.emplace_left(current, key);
+			else btree.emplace_right(current, key);
+			break;
+		}
+	}
+
+	return btree;
+}
+
+void bench_binary_tree_layout()
+{
+	constexpr int count = 1 << 20;
+	constexpr int queries = 1 << 21;
+
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int> dist(0, count * 4);
+	auto btree = make_random_search_tree(count, gen);
+
+	std::vector<int> keys(queries);
+	std::generate(std::begin(keys), std::end(keys), [&] { return dist(gen); });
+
+	const auto search = [&] {
+		std::size_t found = 0;
+		for (const int key : keys) found += !binary_search_find(btree, btree.root(), key).is_null();
+		std::cout << "found " << found << ", ";
+	};
+
+	measure("insertion order", search);
+	btree.relayout(binary_tree_layout::eytzinger);
+	measure("eytzinger", search);
+	btree.relayout(binary_tree_layout::van_emde_boas);
+	measure("van emde boas", search);
+}
+
+void bench_binary_tree_postorder()
+{
+	constexpr int count = 1 << 20;
+
+	std::mt19937 gen(42);
+	auto btree = make_random_search_tree<binary_tree_augmentation::parent_links>(count, gen);
+
+	long long sum = 0;
+	const auto add = [&sum](int value) { sum += value; };
+
+	measure("traverse_postorder", [&] { traverse_postorder(btree, btree.root(), add); });
+	measure("morris_traversal_postorder", [&] { morris_traversal_postorder(btree, btree.root(), add); });
+	measure("stackless_traversal_postorder", [&] { stackless_traversal_postorder(btree, btree.root(), add); });
+	std::cout << "checksum " << sum << '\n';
+}
+
 void test_graph()
 {
 	graph<std::string> gr;
@@ -87,6 +198,49 @@ void test_graph()
 	std::cout.flush();
 }
 
+void test_graph_copy()
+{
+	auto source = std::make_unique<graph<int>>();
+	auto center = source->emplace_node(0);
+	for (int i = 1; i < 5; ++i)
+		source->emplace_neigbor(center, i);
+
+	const auto expected = source->neighborhood_of(center, 1);
+
+	// Cached neighborhoods are copied, the copy must not refer to the source cache
+	graph<int> copy = *source;
+	source.reset();
+
+	assert(copy.neighborhood_of(center, 1) == expected);
+	assert(copy.neighborhood_cache_hits() == 1);
+
+	graph<int> assigned;
+	assigned = copy;
+	copy.emplace_neigbor(center, 5);
+	assert(std::size(copy.neighborhood_of(center, 1)) == std::size(expected) + 1);
+	assert(assigned.neighborhood_of(center, 1) == expected);
+}
+
+void test_dag()
+{
+	dag<std::string> gr;
+
+	auto compile = gr.emplace_node("compile");
+	auto link = gr.emplace_node("link");
+	auto test = gr.emplace_node("test");
+
+	gr.add_edge(test, link);
+	gr.add_edge(link, compile);
+
+	if (!gr.try_add_edge(compile, test))
+		std::cout << "edge compile -> test rejected\n";
+
+	for (const auto n : gr.topological_order())
+		std::cout << "node: " << gr.value_of(n) << '\n';
+
+	std::cout.flush();
+}
+
 void test_tree()
 {
 	tree<std::string> tr("root");
@@ -102,6 +256,174 @@ void test_tree()
 	std::cout.flush();
 }
 
+void bench_forest_allocation()
+{
+	constexpr int count = 1 << 20;
+
+	std::mt19937 gen(42);
+	std::vector<int> parents(count);
+	for (int i = 1; i < count; ++i)
+		parents[i] = std::uniform_int_distribution<int>(0, i - 1)(gen);
+
+	for (int round = 0; round < 3; ++round)
+	{
+		forest<int> f;
+		std::vector<forest<int>::iterator> nodes;
+		nodes.reserve(count);
+
+		measure("forest construction", [&] {
+			nodes.emplace_back(f.emplace(f.end(), 0));
+			for (int i = 1; i < count; ++i)
+				nodes.emplace_back(f.emplace(trailing_of(nodes[parents[i]]), i));
+		});
+		measure("forest destruction", [&] { f.clear(); });
+	}
+}
+
+forest<int> make_random_forest(int count, std::mt19937& gen)
+{
+	forest<int> result;
+	std::vector<forest<int>::iterator> nodes;
+	nodes.reserve(count);
+
+	nodes.emplace_back(result.emplace(result.end(), 0));
+	for (int i = 1; i < count; ++i)
+	{
+		const auto parent = nodes[std::uniform_int_distribution<int>(0, i - 1)(gen)];
+		nodes.emplace_back(result.emplace(trailing_of(parent), i));
+	}
+
+	return result;
+}
+
+void bench_forest_copy()
+{
+	constexpr int count = 1 << 20;
+
+	std::mt19937 gen(42);
+	const auto source = make_random_forest(count, gen);
+
+	forest<int> inserted;
+	measure("forest insert per node", [&] {
+		inserted.insert(inserted.end(), forest<int>::const_child_iterator(source.begin()), forest<int>::const_child_iterator(source.end()));
+	});
+
+	forest<int> copied;
+	measure("forest copy construction", [&] { forest<int> tmp(source); copied.swap(tmp); });
+	measure("forest copy assignment", [&] { copied = source; });
+	measure("forest move assignment", [&] { inserted = std::move(copied); });
+	measure("forest swap", [&] { swap(inserted, copied); });
+
+	// Copy is laid out in full order, so copying it again walks memory sequentially
+	forest<int> reinserted;
+	measure("forest insert per node (from copy)", [&] {
+		reinserted.insert(reinserted.end(), forest<int>::const_child_iterator(copied.begin()), forest<int>::const_child_iterator(copied.end()));
+	});
+	measure("forest copy assignment (from copy)", [&] { inserted = copied; });
+	std::cout << "equal " << (copied == source && inserted == reinserted) << '\n';
+}
+
+void bench_frozen_forest()
+{
+	constexpr int count = 1 << 20;
+
+	std::mt19937 gen(42);
+	const auto source = make_random_forest(count, gen);
+	const frozen_forest<int> frozen(source);
+
+	long long sum = 0;
+	measure("forest preorder", [&] {
+		for (forest<int>::const_preorder_iterator first(source.begin()), last(source.end()); first != last; ++first)
+			sum += *first;
+	});
+	measure("frozen_forest preorder", [&] {
+		for (frozen_forest<int>::const_preorder_iterator first(frozen.begin()), last(frozen.end()); first != last; ++first)
+			sum += *first;
+	});
+	std::cout << "checksum " << sum << '\n';
+}
+
+void bench_forest_erase()
+{
+	constexpr int count = 1 << 20;
+
+	std::mt19937 gen(42);
+	auto f = make_random_forest(count, gen);
+	auto copy = f;
+
+	measure("forest erase subtrees", [&] {
+		const auto root = f.begin();
+		f.erase(std::next(root), trailing_of(root));
+	});
+	measure("forest erase all", [&] { copy.erase(copy.begin(), copy.end()); });
+	std::cout << "sizes " << f.size() << ' ' << copy.size() << '\n';
+}
+
+void bench_forest_conversions()
+{
+	constexpr int count = 1 << 20;
+
+	std::mt19937 gen(42);
+	const auto numbers = make_random_forest(count, gen);
+	forest<std::string> source;
+	std::vector<forest<std::string>::iterator> opened;
+	for (auto it = numbers.begin(); it != numbers.end(); ++it)
+	{
+		if (it.is_trailing())
+		{
+			opened.pop_back();
+			continue;
+		}
+
+		const auto pos = opened.empty() ? source.end() : trailing_of(opened.back());
+		opened.emplace_back(source.emplace(pos, std::string(32, 'a' + *it % 26)));
+	}
+
+	binary_tree<std::string> btree(empty_binary_tree);
+	tree<std::string> tr("");
+	forest<std::string> result;
+
+	measure("forest_to_binary_tree copy", [&] { btree = forest_to_binary_tree(source); });
+	measure("binary_tree_to_forest copy", [&] { result = binary_tree_to_forest(btree); });
+	measure("forest_to_tree copy", [&] { tr = forest_to_tree(source); });
+	measure("tree_to_forest copy", [&] { result = tree_to_forest(tr); });
+
+	forest<std::string> moved(source);
+	measure("forest_to_binary_tree move", [&] { btree = forest_to_binary_tree(std::move(moved)); });
+	measure("binary_tree_to_forest move", [&] { moved = binary_tree_to_forest(std::move(btree)); });
+	measure("forest_to_tree move", [&] { tr = forest_to_tree(std::move(moved)); });
+	measure("tree_to_forest move", [&] { moved = tree_to_forest(std::move(tr)); });
+	std::cout << "equal " << (moved == source) << '\n';
+}
+
+void bench_forest_views()
+{
+	constexpr int count = 1 << 20;
+
+	std::mt19937 gen(42);
+	const auto source = make_random_forest(count, gen);
+	const auto pred = [](int value) { return value % 8 != 7; };
+
+	long long sum = 0;
+	measure("copy and prune", [&] {
+		forest<int> copy(source);
+		for (auto it = copy.begin(); it != copy.end();)
+		{
+			if (it.is_leading() && !pred(*it)) it = copy.erase(it, std::next(trailing_of(it)));
+			else ++it;
+		}
+
+		for (forest<int>::preorder_iterator first(copy.begin()), last(copy.end()); first != last; ++first)
+			sum += *first;
+	});
+	measure("filtered view", [&] {
+		const auto view = filtered_view(source, pred);
+		for (decltype(view)::preorder_iterator first(view.begin()), last(view.end()); first != last; ++first)
+			sum += *first;
+	});
+	std::cout << "sum " << sum << '\n';
+}
+
 void test_forest()
 {
 	forest<std::string> f;
@@ -122,9 +444,49 @@ void test_forest()
 	std::cout << std::endl;
 }
 
+struct labeled_item : forest_node_base<labeled_item>
+{
+	explicit labeled_item(std::string l) : label{ std::move(l) } {}
+	std::string label;
+};
+
+void test_intrusive_forest()
+{
+	// Items are copied and moved while the vector grows, the copies start unlinked
+	std::vector<labeled_item> items;
+	for (const char* label : { "A", "B", "C", "D", "E" })
+		items.push_back(labeled_item(label));
+
+	intrusive_forest<labeled_item> f;
+	for (const auto& item : items)
+		assert(!item.is_linked());
+
+	f.insert(f.end(), items[0]);
+	f.insert(f.end(), items[4]);
+
+	auto a = trailing_of(f.begin());
+	f.insert(a, items[1]);
+	f.insert(a, items[2]);
+	f.insert(a, items[3]);
+
+	labeled_item copy(items[2]);
+	assert(items[2].is_linked() && !copy.is_linked());
+
+	intrusive_forest<labeled_item>::preorder_iterator first = f.begin();
+	intrusive_forest<labeled_item>::preorder_iterator last = f.end();
+
+	for (; first != last; ++first)
+		std::cout << first->label << '\n';
+
+	std::cout << std::endl;
+}
+
 
 int main()
 {
+	test_binary_tree_ranges();
+	test_graph_copy();
 	test_forest();
+	test_intrusive_forest();
 	return 0;
 }
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+
+/*
+	Persistent ordered set balanced as AVL tree.
+	Every update copies only the path from the root to the changed node (O(log n)),
+	unchanged subtrees are shared between versions. Nodes are immutable and
+	reference counted, so a version is released together with the last snapshot using it.
+
+	get_snapshot(), size() and empty() are O(1) and may be called while a single writer
+	keeps updating the tree, readers work on their snapshot without locks.
+	Lookups are made on a snapshot, values they point to stay valid while the snapshot lives.
+
+	persistent_tree is an independent ordered set rather than a mode of binary_tree:
+	binary_tree nodes are owned by a registry and addressed by index, so they can't be
+	shared between versions.
+*/
+namespace persistent_tree_impl
+{
+
+	template<typename T>
+	struct node
+	{
+		using pointer = std::shared_ptr<const node>;
+
+		explicit node(T v, pointer l, pointer r)
+			: value{ std::move(v) }
+			, left{ std::move(l) }
+			, right{ std::move(r) }
+			, height{ 1 + std::max(height_of(left), height_of(right)) }
+			, count{ 1 + count_of(left) + count_of(right) }
+		{}
+
+		static int height_of(const pointer& n) { return n ? n->height : 0; }
+		static std::size_t count_of(const pointer& n) { return n ? n->count : 0; }
+
+		T value;
+		pointer left;
+		pointer right;
+		int height;
+		std::size_t count;
+	};
+
+}
+
+
+template<typename T, typename Compare = std::less<>>
+class persistent_tree
+{
+	using node = persistent_tree_impl::node<T>;
+	using node_pointer = typename node::pointer;
+
+public:
+	// Immutable version of the tree
+	class snapshot
+	{
+		friend class persistent_tree;
+
+		explicit snapshot(node_pointer root, Compare comp)
+			: root_{ std::move(root) }, comp_{ comp }
+		{}
+
+	public:
+		std::size_t size() const { return node::count_of(root_); }
+		bool empty() const { return !root_; }
+
+		// Returns pointer to the equivalent value or nullptr
+		template<typename Key>
+		const T* find(const Key& key) const
+		{
+			const T* result = lower_bound(key);
+			return (result == nullptr || comp_(key, *result)) ? nullptr : result;
+		}
+
+		// Returns pointer to the first value not less than key or nullptr
+		template<typename Key>
+		const T* lower_bound(const Key& key) const
+		{
+			const T* result = nullptr;
+			for (const node* current = root_.get(); current != nullptr;)
+			{
+				if (comp_(current->value, key))
+				{
+					current = current->right.get();
+				}
+				else
+				{
+					result = &current->value;
+					current = current->left.get();
+				}
+			}
+
+			return result;
+		}
+
+		template<typename Func>
+		void traverse_inorder(Func&& func) const
+		{
+			std::vector<const node*> nodes;
+			for (const node* current = root_.get(); current != nullptr || !nodes.empty();)
+			{
+				if (current != nullptr)
+				{
+					nodes.emplace_back(current);
+					current = current->left.get();
+				}
+				else
+				{
+					current = nodes.back();
+					nodes.pop_back();
+					func(current->value);
+					current = current->right.get();
+				}
+			}
+		}
+
+	private:
+		node_pointer root_;
+		Compare comp_;
+	};
+
+	explicit persistent_tree(Compare comp = Compare()) : root_{}, comp_{ comp } {}
+
+	snapshot get_snapshot() const { return snapshot(std::atomic_load(&root_), comp_); }
+
+	std::size_t size() const { return get_snapshot().size(); }
+	bool empty() const { return get_snapshot().empty(); }
+
+	// Only the writer replaces root_, so it may read it without synchronization
+	bool insert(const T& value)
+	{
+		bool inserted = false;
+		auto root = insert(root_, value, inserted);
+		if (inserted) publish(std::move(root));
+		return inserted;
+	}
+
+	template<typename Key>
+	bool erase(const Key& key)
+	{
+		bool erased = false;
+		auto root = erase(root_, key, erased);
+		if (erased) publish(std::move(root));
+		return erased;
+	}
+
+private:
+	void publish(node_pointer root) { std::atomic_store(&root_, std::move(root)); }
+
+	static node_pointer make(T value, node_pointer left, node_pointer right)
+	{
+		return std::make_shared<const node>(std::move(value), std::move(left), std::move(right));
+	}
+
+	// Builds node from value and AVL subtrees whose heights differ at most by 2
+	static node_pointer balance(T value, node_pointer left, node_pointer right)
+	{
+		const int leftHeight = node::height_of(left);
+		const int rightHeight = node::height_of(right);
+
+		if (leftHeight > rightHeight + 1)
+		{
+			if (node::height_of(left->left) >= node::height_of(left->right))
+				return make(left->value, left->left, make(std::move(value), left->right, std::move(right)));
+
+			const auto& middle = left->right;
+			return make(middle->value, make(left->value, left->left, middle->left), make(std::move(value), middle->right, std::move(right)));
+		}
+
+		if (rightHeight > leftHeight + 1)
+		{
+			if (node::height_of(right->right) >= node::height_of(right->left))
+				return make(right->value, make(std::move(value), std::move(left), right->left), right->right);
+
+			const auto& middle = right->left;
+			return make(middle->value, make(std::move(value), std::move(left), middle->left), make(right->value, middle->right, right->right));
+		}
+
+		return make(std::move(value), std::move(left), std::move(right));
+	}
+
+	node_pointer insert(const node_pointer& n, const T& value, bool& inserted) const
+	{
+		if (!n)
+		{
+			inserted = true;
+			return make(value, nullptr, nullptr);
+		}
+
+		if (comp_(value, n->value))
+		{
+			auto left = insert(n->left, value, inserted);
+			return inserted ? balance(n->value, std::move(left), n->right) : n;
+		}
+
+		if (comp_(n->value, value))
+		{
+			auto right = insert(n->right, value, inserted);
+			return inserted ? balance(n->value, n->left, std::move(right)) : n;
+		}
+
+		return n;
+	}
+
+	static node_pointer erase_leftmost(const node_pointer& n)
+	{
+		if (!n->left) return n->right;
+		return balance(n->value, erase_leftmost(n->left), n->right);
+	}
+
+	template<typename Key>
+	node_pointer erase(const node_pointer& n, const Key& key, bool& erased) const
+	{
+		if (!n) return n;
+
+		if (comp_(key, n->value))
+		{
+			auto left = erase(n->left, key, erased);
+			return erased ? balance(n->value, std::move(left), n->right) : n;
+		}
+
+		if (comp_(n->value, key))
+		{
+			auto right = erase(n->right, key, erased);
+			return erased ? balance(n->value, n->left, std::move(right)) : n;
+		}
+
+		erased = true;
+		if (!n->left) return n->right;
+		if (!n->right) return n->left;
+
+		const node* successor = n->right.get();
+		while (successor->left) successor = successor->left.get();
+
+		return balance(successor->value, n->left, erase_leftmost(n->right));
+	}
+
+private:
+	node_pointer root_;
+	Compare comp_;
+};
@@ -1,43 +1,67 @@
 #pragma once
 
 #include <vector>
+#include <limits>
+#include <tuple>
 #include <utility>
 #include <optional>
 #include <algorithm>
 #include <stdexcept>
 
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
 
-template<class T>
+
+namespace registry_impl
+{
+
+    inline void prefetch(const void* p)
+    {
+#if defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+        __builtin_prefetch(p);
+#endif
+    }
+
+}
+
+// Index is the type of ids, its maximum value is never issued as an id
+template<class T, class Index = std::size_t>
 class registry 
 {
 public:
 
     template<typename... Args>
-    std::size_t emplace(Args&&... args)
+    Index emplace(Args&&... args)
     {
-        const std::size_t currID = id_;
-        elems_.emplace_back(currID, std::forward<Args>(args)...);
+        if (id_ == std::numeric_limits<Index>::max())
+            throw std::length_error("registry ids are exhausted");
+
+        const Index currID = id_;
+        elems_.emplace_back(std::piecewise_construct, std::forward_as_tuple(currID), std::forward_as_tuple(std::in_place, std::forward<Args>(args)...));
         ++size_;
         ++id_;
         return currID;
     }
 
-    const T& value(std::size_t id) const
+    const T& value(Index id) const
     {
-        const auto p = std::lower_bound(std::begin(elems_), std::end(elems_), id, [](const auto& a, const auto& b) { return a.first < b; });
-        if (p == std::end(elems_) || p->first != id || !p->second)
+        const auto p = find(id);
+        if (p == std::end(elems_) || !p->second)
             throw std::invalid_argument("value with this id not found");
 
         return *p->second;
     }
 
-    T& value(std::size_t id) { return const_cast<T&>(const_cast<const registry*>(this)->value(id)); }
+    T& value(Index id) { return const_cast<T&>(const_cast<const registry*>(this)->value(id)); }
 
-    void erase(std::size_t id) 
+    void erase(Index id) 
     {
-        const auto p = std::lower_bound(std::begin(elems_), std::end(elems_), id, [](const auto& a, const auto& b) { return a.first < b; });
+        const auto p = elems_.begin() + (find(id) - elems_.cbegin());
 
-        if (p == std::end(elems_) || p->first != id) return;
+        if (p == std::end(elems_) || !p->second) return;
 
         p->second.reset();
         --size_;
@@ -53,8 +77,42 @@ public:
             if (e.second) f(*e.second);
     }
 
+    template<class F>
+    void for_each_id(F f) const
+    {
+        for (const auto& e : elems_)
+            if (e.second) f(e.first);
+    }
+
+    std::size_t size() const { return size_; }
+    void reserve(std::size_t n) { elems_.reserve(n); }
+
+    // Hint that value with this id is going to be accessed soon.
+    // Element position is known without a lookup only until the first compaction,
+    // after it the hint is ignored.
+    void prefetch(Index id) const
+    {
+        if (std::size(elems_) == id_ && id < id_) registry_impl::prefetch(&elems_[id]);
+    }
+
+    // All ids ever issued are less than this value
+    std::size_t id_bound() const { return id_; }
+
+private:
+    using elements = std::vector<std::pair<Index, std::optional<T>>>;
+
+    typename elements::const_iterator find(Index id) const
+    {
+        // Ids are dense until the first compaction, so the element usually sits at position id
+        if (id < std::size(elems_) && elems_[id].first == id)
+            return elems_.cbegin() + id;
+
+        const auto p = std::lower_bound(std::begin(elems_), std::end(elems_), id, [](const auto& a, const auto& b) { return a.first < b; });
+        return (p == std::end(elems_) || p->first != id) ? std::end(elems_) : p;
+    }
+
 private:
-    std::size_t id_ = 0;
+    Index id_ = 0;
     std::size_t size_ = 0;
-    std::vector<std::pair<std::size_t, std::optional<T>>> elems_;
+    elements elems_;
 };
\ No newline at end of file
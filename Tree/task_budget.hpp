@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+
+// Limits the number of tasks running at once during one parallel traversal
+class task_budget
+{
+public:
+	explicit task_budget(std::size_t tasks) : available_{ tasks } {}
+
+	// One task per hardware thread besides the calling one
+	static std::size_t hardware_tasks() { return std::max(1u, std::thread::hardware_concurrency()) - 1; }
+
+	// Takes up to wanted tasks, returns how many were taken
+	std::size_t acquire(std::size_t wanted)
+	{
+		std::size_t available = available_.load();
+		std::size_t taken = 0;
+		do
+		{
+			taken = std::min(available, wanted);
+		} while (taken > 0 && !available_.compare_exchange_weak(available, available - taken));
+
+		return taken;
+	}
+
+	void release(std::size_t count) { available_ += count; }
+
+private:
+	std::atomic<std::size_t> available_;
+};
+
+
+// Returns one acquired task to the budget when the task finishes, also by exception
+class task_budget_slot
+{
+public:
+	explicit task_budget_slot(task_budget& budget) : budget_{ &budget } {}
+	~task_budget_slot() { budget_->release(1); }
+
+	task_budget_slot(const task_budget_slot&) = delete;
+	task_budget_slot& operator=(const task_budget_slot&) = delete;
+
+private:
+	task_budget* budget_;
+};
@@ -9,47 +9,51 @@
 #include <limits>
 
 
-class tree_node
+template<typename Index>
+class basic_tree_node
 {
 public:
-	explicit tree_node(std::size_t index) : index_{ index } { }
-	std::size_t index() const { return index_; }
+	explicit basic_tree_node(Index index) : index_{ index } { }
+	Index index() const { return index_; }
 
-	friend bool operator==(const tree_node& lhs, const tree_node& rhs) { return lhs.index() == rhs.index(); }
-	friend bool operator!=(const tree_node& lhs, const tree_node& rhs) { return lhs.index() != rhs.index(); }
+	friend bool operator==(const basic_tree_node& lhs, const basic_tree_node& rhs) { return lhs.index() == rhs.index(); }
+	friend bool operator!=(const basic_tree_node& lhs, const basic_tree_node& rhs) { return lhs.index() != rhs.index(); }
 
-	friend bool operator<(const tree_node& lhs, const tree_node& rhs) { return lhs.index() < rhs.index(); }
-	friend bool operator>(const tree_node& lhs, const tree_node& rhs) { return lhs.index() > rhs.index(); }
+	friend bool operator<(const basic_tree_node& lhs, const basic_tree_node& rhs) { return lhs.index() < rhs.index(); }
+	friend bool operator>(const basic_tree_node& lhs, const basic_tree_node& rhs) { return lhs.index() > rhs.index(); }
 
-	friend bool operator<=(const tree_node& lhs, const tree_node& rhs) { return lhs.index() <= rhs.index(); }
-	friend bool operator>=(const tree_node& lhs, const tree_node& rhs) { return lhs.index() >= rhs.index(); }
+	friend bool operator<=(const basic_tree_node& lhs, const basic_tree_node& rhs) { return lhs.index() <= rhs.index(); }
+	friend bool operator>=(const basic_tree_node& lhs, const basic_tree_node& rhs) { return lhs.index() >= rhs.index(); }
 
 private:
-	std::size_t index_;
+	Index index_;
 };
 
+using tree_node = basic_tree_node<std::size_t>;
+
 
 namespace tree_impl
 {
 
+	template<typename Index>
 	class inner_node
 	{
 	public:
-		void add_child(std::size_t nodeIndex)
+		void add_child(Index nodeIndex)
 		{
-			assert(std::find(std::cbegin(children_), std::cend(children_), tree_node(nodeIndex)) == std::cend(children_));
+			assert(std::find(std::cbegin(children_), std::cend(children_), basic_tree_node<Index>(nodeIndex)) == std::cend(children_));
 			children_.emplace_back(nodeIndex);
 		}
 
-		std::vector<tree_node>& children() { return children_; }
-		const std::vector<tree_node>& children() const { return children_; }
+		std::vector<basic_tree_node<Index>>& children() { return children_; }
+		const std::vector<basic_tree_node<Index>>& children() const { return children_; }
 
 	private:
-		std::vector<tree_node> children_;
+		std::vector<basic_tree_node<Index>> children_;
 	};
 
-	template<typename T>
-	class inner_data_node : public inner_node
+	template<typename T, typename Index>
+	class inner_data_node : public inner_node<Index>
 	{
 	public:
 		template<typename... Args>
@@ -65,57 +69,68 @@ namespace tree_impl
 }
 
 
-template<typename T>
+template<typename T, typename Index = std::size_t>
 class tree
 {
-	friend class tree_node;
 public:
-	using node_iterator = std::vector<tree_node>::iterator;
-	using const_node_iterator = std::vector<tree_node>::const_iterator;
+	using node = basic_tree_node<Index>;
+	using node_iterator = typename std::vector<node>::iterator;
+	using const_node_iterator = typename std::vector<node>::const_iterator;
 
 	template<typename... Args>
 	explicit tree(Args&&... args)
 		: root_{0}
 		, nodes_()
 	{
-		root_ = tree_node(nodes_.emplace(std::forward<Args>(args)...));
+		root_ = node(nodes_.emplace(std::forward<Args>(args)...));
+	}
+
+	std::size_t size() const { return nodes_.size(); }
+	void reserve(std::size_t count) { nodes_.reserve(count); }
+
+	// Tree always has a root, so clear keeps only the root value. All node handles are invalidated.
+	void clear()
+	{
+		registry<tree_impl::inner_data_node<T, Index>, Index> kept;
+		root_ = node(kept.emplace(std::move(value_of(root_))));
+		nodes_ = std::move(kept);
 	}
 
-	tree_node root() const { return root_; }
-	void set_root(const tree_node& n) { root_ = n; }
+	node root() const { return root_; }
+	void set_root(const node& n) { root_ = n; }
 
 	template<typename... Args>
-	tree_node emplace_child(const tree_node& parent, Args&&... args)
+	node emplace_child(const node& parent, Args&&... args)
 	{
 		const auto lastNodeIndex = nodes_.emplace(std::forward<Args>(args)...);
 		node_at(parent.index()).add_child(lastNodeIndex);
-		return tree_node(lastNodeIndex);
+		return node(lastNodeIndex);
 	}
 
-	void add_child(const tree_node& parent, const tree_node& child)
+	void add_child(const node& parent, const node& child)
 	{
 		if (parent == child) throw std::invalid_argument("node can't be self parent");
 		node_at(parent.index()).add_child(child.index());
 	}
 
-	const T& value_of(const tree_node& n) const { return nodes_.value(n.index()).value(); }
-	T& value_of(const tree_node& n) { return nodes_.value(n.index()).value(); }
+	const T& value_of(const node& n) const { return nodes_.value(n.index()).value(); }
+	T& value_of(const node& n) { return nodes_.value(n.index()).value(); }
 
-	node_iterator begin(const tree_node& n) { return std::begin(node_at(n.index()).children()); }
-	node_iterator end(const tree_node& n) { return std::end(node_at(n.index()).children()); }
+	node_iterator begin(const node& n) { return std::begin(node_at(n.index()).children()); }
+	node_iterator end(const node& n) { return std::end(node_at(n.index()).children()); }
 
-	const_node_iterator cbegin(const tree_node& n) const { return std::begin(node_at(n.index()).children()); }
-	const_node_iterator cend(const tree_node& n) const { return std::end(node_at(n.index()).children()); }
+	const_node_iterator cbegin(const node& n) const { return std::begin(node_at(n.index()).children()); }
+	const_node_iterator cend(const node& n) const { return std::end(node_at(n.index()).children()); }
 
-	const_node_iterator begin(const tree_node& n) const { return cbegin(n); }
-	const_node_iterator end(const tree_node& n) const { return cend(n); }
+	const_node_iterator begin(const node& n) const { return cbegin(n); }
+	const_node_iterator end(const node& n) const { return cend(n); }
 
 
 	class node_range
 	{
 		friend tree;
 
-		explicit node_range(tree* pGraph, tree_node n)
+		explicit node_range(tree* pGraph, node n)
 			: pTree_{ pGraph }
 			, node_{ n }
 		{ assert(pTree_ != nullptr); }
@@ -129,14 +144,14 @@ public:
 
 	private:
 		tree* pTree_;
-		tree_node node_;
+		node node_;
 	};
 
 	class const_node_range
 	{
 		friend tree;
 
-		explicit const_node_range(tree* pGraph, tree_node n)
+		explicit const_node_range(const tree* pGraph, node n)
 			: pTree_{ pGraph }
 			, node_{ n }
 		{ assert(pTree_ != nullptr); }
@@ -149,18 +164,18 @@ public:
 		const_node_iterator end() const { return pTree_->end(node_); }
 
 	private:
-		tree* pTree_;
-		tree_node node_;
+		const tree* pTree_;
+		node node_;
 	};
 
-	node_range children_of(const tree_node& n) { return node_range(this, n); }
-	const_node_range children_of(const tree_node& n) const { return const_node_range(this, n); }
+	node_range children_of(const node& n) { return node_range(this, n); }
+	const_node_range children_of(const node& n) const { return const_node_range(this, n); }
 
 private:
-	const tree_impl::inner_node& node_at(std::size_t index) const { return nodes_.value(index); }
-	tree_impl::inner_node& node_at(std::size_t index) { return nodes_.value(index); }
+	const tree_impl::inner_node<Index>& node_at(Index index) const { return nodes_.value(index); }
+	tree_impl::inner_node<Index>& node_at(Index index) { return nodes_.value(index); }
 
 private:
-	tree_node root_;
-	registry<tree_impl::inner_data_node<T>> nodes_;
+	node root_;
+	registry<tree_impl::inner_data_node<T, Index>, Index> nodes_;
 };